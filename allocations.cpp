@@ -0,0 +1,42 @@
+#include "allocations.h"
+
+#ifdef MILS_COUNT_ALLOCATIONS
+
+#include <new>
+#include <cstdlib>
+
+namespace {
+    thread_local size_t nAllocations = 0;
+}
+
+size_t allocationCount() {
+    return nAllocations;
+}
+
+void* operator new(std::size_t size) {
+    ++nAllocations;
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    ++nAllocations;
+    std::size_t a = static_cast<std::size_t>(alignment);
+    if (void *ptr = std::aligned_alloc(a, (size + a - 1) / a * a))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+#else
+
+size_t allocationCount() {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef MILS_ALLOCATIONS_H
+#define MILS_ALLOCATIONS_H
+
+#include <cstddef>
+
+// Test hook for checking that the generation loop does not allocate. Compile with -DMILS_COUNT_ALLOCATIONS to
+// replace the global operator new with a counting version; simulate() then reports the heap allocations done by
+// its thread during steady-state generations, and fails the run (non-zero exit) if there were any. Without the
+// define nothing is replaced and the count stays 0. Check every mode that promises an allocation-free loop:
+//     g++ -std=c++17 -O2 -pthread -DMILS_COUNT_ALLOCATIONS -I. *.cpp -o mils_counting
+//     for mode in "" storage=compact outputFormat=binary asyncOutput=0 "asyncOutput=0 outputFormat=binary" detailedStats=1 \
+//                 "chunkSize=500 chunkThreads=3" "nDemes=4 demeThreads=4 migrationInterval=1"; do
+//         ./mils_counting popSize=5000 maxGens=2000 nReplicates=1 fixedSeed=5 $mode || echo "FAILED: $mode"
+//     done
+
+// Number of heap allocations made by the calling thread so far
+size_t allocationCount();
+
+// Whether the counting operator new is compiled in
+constexpr bool allocationCountingEnabled() {
+#ifdef MILS_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+#endif //MILS_ALLOCATIONS_H
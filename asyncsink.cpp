@@ -0,0 +1,127 @@
+#include "asyncsink.h"
+#include "instrumentation.h"
+
+asyncSink::asyncSink(std::unique_ptr<tableSink> inner, const size_t &queueBlocks, const size_t &blockRows)
+    : tableSink(inner->getColumns()), inner(std::move(inner)), blockRows(blockRows), full(queueBlocks), empty(queueBlocks + 2) {
+    current.values.resize(blockRows * columns.size());
+#ifdef MILS_INSTRUMENT
+    writer = std::thread([this, owner = &instrumentation::local()]() {
+        instrumentation::reportTo(owner);				// Bytes written count towards the run that produced them
+        writerLoop();
+    });
+#else
+    writer = std::thread(&asyncSink::writerLoop, this);
+#endif
+}
+
+asyncSink::~asyncSink() {
+    try {
+        close();
+    }
+    catch (...) {}
+    stopWriter();										// Also when close() failed before stopping it
+}
+
+void asyncSink::addRow(const double *values) {
+    const size_t n = columns.size();
+    std::copy(values, values + n, current.values.begin() + current.nRows * n);
+    if (++current.nRows == blockRows)
+        push(current);
+}
+
+void asyncSink::flush() {
+    current.flush = true;
+    ++flushesRequested;
+    push(current);
+    {
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        producerWake.wait(lock, [this]() { return flushesDone >= flushesRequested || failed; });
+    }
+    rethrowWriterError();
+}
+
+void asyncSink::close() {
+    if (!writer.joinable())								// Closed already
+        return;
+    flush();
+    stopWriter();
+    inner->close();										// The writer thread is gone, so this thread owns the wrapped sink
+}
+
+void asyncSink::push(block &b) {
+    rethrowWriterError();
+    block next;
+    if (!empty.tryPop(next))							// Reuse a block the writer is done with, if there is one
+        next.values.resize(blockRows * columns.size());
+    next.nRows = 0;
+    next.flush = false;
+
+    while (!full.tryPush(b)) {							// Queue full: wait for the writer (backpressure)
+        rethrowWriterError();
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        producerWake.wait(lock, [this]() { return !full.isFull() || failed; });
+    }
+    b = std::move(next);
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);	// Between the push and the notify, so a writer about to sleep sees the block
+    }
+    writerWake.notify_one();
+}
+
+void asyncSink::stopWriter() {
+    if (!writer.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stop = true;
+    }
+    writerWake.notify_one();
+    writer.join();
+}
+
+void asyncSink::wakeProducer() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+    }
+    producerWake.notify_one();
+}
+
+void asyncSink::writerLoop() {
+    block b;
+    while (true) {
+        if (!full.tryPop(b)) {							// Nothing to write: sleep until there is, or until stopped
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            writerWake.wait(lock, [this]() { return !full.isEmpty() || stop; });
+            if (full.isEmpty())
+                return;
+            continue;
+        }
+        wakeProducer();									// A slot came free
+        if (!failed) {
+            try {
+                const size_t n = columns.size();
+                for (size_t r = 0; r < b.nRows; ++r)
+                    inner->addRow(&b.values[r * n]);
+                if (b.flush)
+                    inner->flush();
+            }
+            catch (...) {
+                writerError = std::current_exception();
+                failed = true;
+            }
+        }
+        if (b.flush)
+            ++flushesDone;								// Also on failure, so flush() doesn't wait forever
+        if (b.flush || failed)
+            wakeProducer();
+        empty.tryPush(b);								// Dropped (freed) if the reuse queue is full
+    }
+}
+
+void asyncSink::rethrowWriterError() {
+    if (failed && writerError) {
+        std::exception_ptr error = writerError;
+        writerError = nullptr;
+        std::rethrow_exception(error);
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef MILS_ASYNCSINK_H
+#define MILS_ASYNCSINK_H
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <exception>
+#include "output.h"
+
+// Bounded lock-free single-producer/single-consumer ring buffer
+template<typename T>
+class spscQueue {
+public:
+    explicit spscQueue(const size_t &capacity) : slots(capacity + 1) {}
+
+    bool tryPush(T &item) {								// Moves item in; false if the queue is full
+        const size_t t = tail.load(std::memory_order_relaxed);
+        const size_t next = (t + 1) % slots.size();
+        if (next == head.load(std::memory_order_acquire))
+            return false;
+        slots[t] = std::move(item);
+        tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T &item) {								// Moves the oldest item out; false if the queue is empty
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+        item = std::move(slots[h]);
+        head.store((h + 1) % slots.size(), std::memory_order_release);
+        return true;
+    }
+
+    bool isEmpty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+    bool isFull() const { return (tail.load(std::memory_order_acquire) + 1) % slots.size() == head.load(std::memory_order_acquire); }
+
+private:
+    std::vector<T> slots;
+    alignas(64) std::atomic<size_t> head{ 0 };			// Next slot to pop (owned by the consumer)
+    alignas(64) std::atomic<size_t> tail{ 0 };			// Next slot to push (owned by the producer)
+};
+
+//Class def:
+// Output sink that hands rows to a background writer thread. The simulation thread copies rows into blocks
+// and pushes full blocks into a bounded queue; the writer thread passes them on to the wrapped sink, which does
+// the formatting and disk writes. When the queue is full the simulation thread waits (backpressure), so memory
+// use stays bounded by queueBlocks * blockRows rows. The rows themselves pass through the lock-free queues; the
+// mutex is only taken, once per block, to wake a thread that sleeps on an empty or full queue.
+class asyncSink : public tableSink {
+public:
+    asyncSink(std::unique_ptr<tableSink> inner, const size_t &queueBlocks = 8, const size_t &blockRows = 4096);
+    ~asyncSink() override;								// Closes (errors are dropped; call close() to see them)
+
+    void addRow(const double *values) override;
+    void flush() override;								// Blocks until every row so far is written by the wrapped sink
+    void close() override;								// Flushes, stops the writer thread and closes the wrapped sink
+    uint64_t bytesWritten() const override { return inner->bytesWritten(); }	// Only meaningful right after flush()
+
+private:
+    struct block {
+        std::vector<double> values;						// nRows rows of columns.size() values
+        size_t nRows = 0;
+        bool flush = false;								// Flush the wrapped sink after writing this block
+    };
+
+    void push(block &b);								// Hand a block to the writer thread, waiting while the queue is full
+    void writerLoop();
+    void stopWriter();
+    void wakeProducer();
+    void rethrowWriterError();
+
+    std::unique_ptr<tableSink> inner;
+    size_t blockRows;
+    block current;										// Block being filled by the simulation thread
+    spscQueue<block> full;								// Simulation thread -> writer thread
+    spscQueue<block> empty;								// Writer thread -> simulation thread: blocks to reuse
+    std::atomic<bool> stop{ false };
+    std::atomic<size_t> flushesDone{ 0 };
+    size_t flushesRequested = 0;
+    std::atomic<bool> failed{ false };
+    std::exception_ptr writerError = nullptr;			// Written by the writer thread before 'failed' is set
+    std::mutex wakeMutex;
+    std::condition_variable writerWake;					// Queue no longer empty, or stop
+    std::condition_variable producerWake;				// Queue no longer full, a flush done, or the writer failed
+    std::thread writer;
+};
+
+#endif //MILS_ASYNCSINK_H
@@ -0,0 +1,113 @@
+// Benchmark: parent sampling cost of one generation in reproduceSheep, as a function of popSize.
+// Compares the old approach (a fresh std::discrete_distribution per dead sheep) with one aliasTable per generation,
+// first for the sampling alone, then for a whole generation of simulate(): addDamage, kill, advanceAge and reproduction,
+// where the old approach draws the parents of placeOffspring with discrete_distribution instead of sampleParents.
+//
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -pthread -I. benchmarks/sampling_benchmark.cpp allocations.cpp asyncsink.cpp checkpoint.cpp cohortevents.cpp herd.cpp
+//         herdchunks.cpp herddemes.cpp herdstats.cpp instrumentation.cpp output.cpp parameters.cpp randomnumbers.cpp sheep.cpp simulation.cpp threadpool.cpp
+//         -o sampling_benchmark
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <random>
+#include "randomnumbers.h"
+#include "parameters.h"
+#include "herd.h"
+#include "herdstats.h"
+#include "simulation.h"
+
+const double deathFraction = 0.05;			// Fraction of the herd replaced each generation
+const unsigned long maxOldPopSize = 100000;	// Old approach is quadratic; skip it above this popSize
+const int warmupGenerations = 2;			// Untimed generations before the timed one, so the herd is no longer all newborns
+
+double timeOld(const std::vector<double> &w, const size_t &nDead) {
+    auto start = std::chrono::steady_clock::now();
+    long checksum = 0;
+    for (size_t j = 0; j < nDead; ++j) {
+        std::discrete_distribution<> ri(begin(w), end(w));
+        checksum += ri(rng);
+    }
+    auto stop = std::chrono::steady_clock::now();
+    if (checksum < 0) std::cout << checksum;	// Keep the loop from being optimised away
+    return std::chrono::duration<double>(stop - start).count();
+}
+
+double timeAlias(const std::vector<double> &w, const size_t &nDead) {
+    auto start = std::chrono::steady_clock::now();
+    long checksum = 0;
+    aliasTable parents(w);
+    for (size_t j = 0; j < nDead; ++j) {
+        checksum += parents.draw();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    if (checksum < 0) std::cout << checksum;
+    return std::chrono::duration<double>(stop - start).count();
+}
+
+// One whole generation, as simulate() runs it; 'alias' = false draws the parents as reproduceSheep did before the alias table
+double timeGeneration(const parameters &p, herd &vHerd, herdStats &stats, reproductionScratch &scratch, const bool &alias) {
+    auto start = std::chrono::steady_clock::now();
+    vHerd.addDamage(p);
+    vHerd.kill(p, &stats);
+    vHerd.advanceAge(&stats);
+    if (alias)
+        reproduceSheep(vHerd, p, scratch, &stats);
+    else {
+        scratch.offspring.resize(vHerd.size());
+        scratch.deadSheep.clear();
+        for (size_t i = 0; i < vHerd.size(); ++i) {
+            scratch.offspring[i] = offspringWeight(vHerd.gen1[i], p);
+            if (!vHerd.alive[i])
+                scratch.deadSheep.push_back(i);
+        }
+        scratch.parentOf.resize(scratch.deadSheep.size());
+        for (size_t j = 0; j < scratch.deadSheep.size(); ++j) {
+            std::discrete_distribution<> ri(scratch.offspring.begin(), scratch.offspring.end());
+            scratch.parentOf[j] = ri(rng);
+        }
+        placeOffspring(vHerd, p, scratch, &stats);
+    }
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(stop - start).count();
+}
+
+double timeWholeGeneration(const parameters &p, const bool &alias) {
+    seedRng(12345);										// Same herd for both approaches
+    herd vHerd = initiatePopulation(p);
+    herdStats stats(p);
+    stats.rebuild(vHerd);
+    reproductionScratch scratch;
+    scratch.reserve(p.popSize);
+    for (int gen = 0; gen < warmupGenerations; ++gen)
+        timeGeneration(p, vHerd, stats, scratch, true);
+    return timeGeneration(p, vHerd, stats, scratch, alias);
+}
+
+int main() {
+    rng.seed(12345);
+    std::cout << "popSize,nDead,discreteDistribution_s,aliasTable_s,generationDiscreteDistribution_s,generationAliasTable_s" << std::endl;
+
+    for (unsigned long n : {1000ul, 10000ul, 100000ul, 1000000ul, 10000000ul}) {
+        std::vector<double> w(n);
+        for (size_t i = 0; i < n; ++i)
+            w[i] = 0.0001 + ru();				// Offspring weights as produced by reproduceSheep
+        size_t nDead = static_cast<size_t>(n * deathFraction);
+
+        std::cout << n << "," << nDead << ",";
+        if (n <= maxOldPopSize)
+            std::cout << timeOld(w, nDead);
+        else
+            std::cout << "NA";
+        std::cout << "," << timeAlias(w, nDead) << ",";
+
+        parameters p;
+        p.popSize = n;
+        if (n <= maxOldPopSize)
+            std::cout << timeWholeGeneration(p, false);
+        else
+            std::cout << "NA";
+        std::cout << "," << timeWholeGeneration(p, true) << std::endl;
+    }
+}
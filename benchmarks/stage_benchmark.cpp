@@ -0,0 +1,210 @@
+// Benchmark: time of each stage of a generation in simulate(), over a matrix of popSize values and thread counts.
+// Every thread runs its own replicate, as runReplicates does, seeded with replicateSeed(seed, thread). Stages:
+//     addDamage       herd::addDamage
+//     kill            herd::kill, including the statistics it gathers in the same pass (see herdstats.h)
+//     parentSampling  sampleParents: offspring weights, alias table, one parent per dead sheep
+//     mutation        placeOffspring: mutation variates and births
+//     statistics      advanceAge and assembling the MGD_ and Stats_ rows from herdStats
+//     output          writing those rows, plus the Individual_Data rows amortised over 5000 generations
+// Results go to stdout (or --json=<file>) as JSON; throughput is in timed sheep-timesteps per second over all threads.
+//
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -pthread -I. benchmarks/stage_benchmark.cpp allocations.cpp asyncsink.cpp checkpoint.cpp cohortevents.cpp herd.cpp
+//         herdchunks.cpp herddemes.cpp herdstats.cpp instrumentation.cpp output.cpp parameters.cpp randomnumbers.cpp sheep.cpp simulation.cpp threadpool.cpp
+//         -o stage_benchmark
+// Usage:
+//     ./stage_benchmark [--popSizes=1000,10000,...] [--threads=1,2,...] [--sheepSteps=N] [--seed=N] [--json=file] [key=value ...]
+// key=value arguments set model parameters, as for the simulation itself.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+#include "parameters.h"
+#include "randomnumbers.h"
+#include "herd.h"
+#include "herdstats.h"
+#include "simulation.h"
+#include "output.h"
+#include "threadpool.h"
+
+const char *stageNames[] = { "addDamage", "kill", "parentSampling", "mutation", "statistics", "output" };
+const int nStages = 6;
+const int warmupGenerations = 2;			// Untimed generations before measuring, so the herd is no longer all newborns
+const unsigned long maxSheep = 100000000;	// Skip combinations with more sheep than this over all threads (about 100 bytes each)
+
+struct stageTimes {
+    double seconds[nStages] = {};
+};
+
+std::vector<unsigned long> parseList(const std::string &text) {
+    std::vector<unsigned long> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        values.push_back(std::stoul(item));
+    return values;
+}
+
+stageTimes runOne(const parameters &p, const int &generations, const std::string &outputBase) {
+    herd vHerd = initiatePopulation(p);
+    herdStats stats(p);
+    stats.rebuild(vHerd);
+    reproductionScratch scratch;
+    scratch.reserve(p.popSize);
+
+    const columnType I = columnType::int32, D = columnType::float64;
+    std::unique_ptr<tableSink> summary = openTable(p, outputBase + "_MGD", cohortColumns());
+    std::unique_ptr<tableSink> detailed = openTable(p, outputBase + "_Stats", detailedStatsColumns(stats));
+    std::unique_ptr<tableSink> individuals = openTable(p, outputBase + "_Individuals",
+        { { "Generation", I }, { "Alive", I }, { "Age", I }, { "Damage1", D }, { "Damage2", D }, { "Gen1", D }, { "Gen2", D }, { "Gen 3", D }, { "DeathCause", I } });
+    std::vector<double> detailedRow(detailedStatsColumns(stats).size());
+    const size_t snapshotChunk = (vHerd.size() + 4999) / 5000;	// Individual_Data rows per generation, amortised
+
+    stageTimes t;
+    auto clock = std::chrono::steady_clock::now();
+    auto lap = [&](const int &stage, const bool &timed) {
+        auto now = std::chrono::steady_clock::now();
+        if (timed)
+            t.seconds[stage] += std::chrono::duration<double>(now - clock).count();
+        clock = now;
+    };
+
+    for (int gen = 0; gen < warmupGenerations + generations; ++gen) {
+        const bool timed = gen >= warmupGenerations;
+        lap(0, false);
+        vHerd.addDamage(p);
+        lap(0, timed);
+        vHerd.kill(p, &stats);
+        lap(1, timed);
+        sampleParents(vHerd, p, scratch);
+        lap(2, timed);
+
+        vHerd.advanceAge(&stats);				// Rows are taken before the dead are replaced, as in simulate()
+        cohortStats s = { gen, stats.genAlive[0].sum(), stats.genAlive[1].sum(), stats.genAlive[2].sum(), int(stats.nAlive()),
+                          stats.damageAlive[0].sum(), stats.damageAlive[1].sum(), int(stats.nDead), stats.damageDead[0].value(), stats.damageDead[1].value() };
+        std::array<double, 10> row = cohortRow(s);
+        detailedStatsRow(stats, gen, detailedRow.data());
+        lap(4, timed);
+
+        summary->addRow(row.data());
+        detailed->addRow(detailedRow.data());
+        const size_t first = (gen * snapshotChunk) % vHerd.size();
+        for (size_t i = first; i < std::min(first + snapshotChunk, vHerd.size()); ++i)
+            individuals->addRow({ double(gen), double(vHerd.alive[i]), double(vHerd.age[i]), vHerd.damageTrait1[i], vHerd.damageTrait2[i],
+                                  vHerd.gen1[i], vHerd.gen2[i], vHerd.gen3[i], double(vHerd.deathCause[i]) });
+        lap(5, timed);
+
+        placeOffspring(vHerd, p, scratch, &stats);
+        lap(3, timed);
+    }
+    summary->close();
+    detailed->close();
+    individuals->close();
+    lap(5, true);
+    return t;
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        parameters p;
+        std::vector<unsigned long> popSizes = { 1000, 10000, 100000, 1000000, 10000000 };
+        std::vector<unsigned long> threadCounts;
+        for (unsigned long n = 1; n < std::thread::hardware_concurrency(); n *= 2)
+            threadCounts.push_back(n);
+        threadCounts.push_back(std::max(1u, std::thread::hardware_concurrency()));
+        double sheepSteps = 2e7;				// Timed sheep-timesteps per thread and combination; sets the number of generations
+        unsigned int seed = 12345;
+        std::string jsonFile;
+
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            std::string key = arg.substr(0, arg.find('=')), value = arg.find('=') == std::string::npos ? "" : arg.substr(arg.find('=') + 1);
+            if (key == "--popSizes")
+                popSizes = parseList(value);
+            else if (key == "--threads")
+                threadCounts = parseList(value);
+            else if (key == "--sheepSteps")
+                sheepSteps = std::stod(value);
+            else if (key == "--seed")
+                seed = std::stoul(value);
+            else if (key == "--json")
+                jsonFile = value;
+            else if (!value.empty())
+                setParameter(p, key[0] == '-' ? key.substr(key.find_first_not_of('-')) : key, value);
+            else
+                throw std::invalid_argument("Unknown argument: " + arg);
+        }
+
+        const std::filesystem::path dir = std::filesystem::temp_directory_path() / "mils_stage_benchmark";
+        std::filesystem::create_directories(dir);
+
+        std::ostringstream json;
+        json << "{\n  \"benchmark\": \"stages\",\n  \"seed\": " << seed << ",\n  \"hardwareThreads\": " << std::thread::hardware_concurrency()
+             << ",\n  \"outputFormat\": \"" << p.outputFormat << "\",\n  \"asyncOutput\": " << p.asyncOutput
+             << ",\n  \"bulkGenerator\": \"" << generatorName(p.bulkGenerator) << "\",\n  \"results\": [";
+        bool first = true;
+
+        for (unsigned long popSize : popSizes) {
+            for (unsigned long nThreads : threadCounts) {
+                if (popSize * nThreads > maxSheep) {
+                    std::cerr << "skipping popSize " << popSize << " on " << nThreads << " threads: too much memory\n";
+                    continue;
+                }
+                parameters q = p;
+                q.popSize = popSize;
+                const int generations = std::max(3, std::min(1000, static_cast<int>(sheepSteps / popSize)));
+                std::cerr << "popSize " << popSize << ", " << nThreads << " threads, " << generations << " generations\n";
+
+                std::vector<stageTimes> times(nThreads);
+                threadPool pool(nThreads);
+                auto start = std::chrono::steady_clock::now();
+                for (unsigned long t = 0; t < nThreads; ++t) {
+                    pool.submit([&, t]() {
+                        seedRng(replicateSeed(seed, t), q.bulkGenerator);
+                        times[t] = runOne(q, generations, (dir / ("thread" + std::to_string(t))).string());
+                    });
+                }
+                pool.wait();
+                double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                double slowest = 0;						// Timed seconds of the slowest thread
+                for (const stageTimes &t : times) {
+                    double total = 0;
+                    for (int s = 0; s < nStages; ++s)
+                        total += t.seconds[s];
+                    slowest = std::max(slowest, total);
+                }
+
+                json << (first ? "\n" : ",\n") << "    { \"popSize\": " << popSize << ", \"threads\": " << nThreads
+                     << ", \"generations\": " << generations << ", \"wallSeconds\": " << wall
+                     << ", \"sheepTimestepsPerSecond\": " << nThreads * popSize * double(generations) / slowest
+                     << ",\n      \"stageSeconds\": {";	// Mean over threads of the time spent in each stage
+                for (int s = 0; s < nStages; ++s) {
+                    double sum = 0;
+                    for (const stageTimes &t : times)
+                        sum += t.seconds[s];
+                    json << (s ? ", " : " ") << "\"" << stageNames[s] << "\": " << sum / nThreads;
+                }
+                json << " } }";
+                first = false;
+            }
+        }
+        json << "\n  ]\n}\n";
+        std::filesystem::remove_all(dir);
+
+        if (jsonFile.empty())
+            std::cout << json.str();
+        else
+            std::ofstream(jsonFile) << json.str();
+    }
+    catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
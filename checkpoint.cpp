@@ -0,0 +1,195 @@
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <stdexcept>
+#include <filesystem>
+#include "checkpoint.h"
+
+namespace {
+    const char magic[8] = { 'M', 'I', 'L', 'S', 'C', 'K', 'P', '2' };
+    const uint32_t byteOrderMark = 0x01020304;		// Checkpoints are only valid on machines with the same byte order
+
+    template<typename T>
+    void put(std::ostream &os, const T &x) {
+        os.write(reinterpret_cast<const char*>(&x), sizeof(T));
+    }
+
+    template<typename T>
+    void putVector(std::ostream &os, const std::vector<T> &v) {
+        put<uint64_t>(os, v.size());
+        os.write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(T));
+    }
+
+    template<typename T>
+    T get(std::istream &is) {
+        T x;
+        if (!is.read(reinterpret_cast<char*>(&x), sizeof(T)))
+            throw std::runtime_error("Truncated checkpoint file");
+        return x;
+    }
+
+    uint64_t getLength(std::istream &is, const uint64_t &fileSize, const size_t &elementSize) {	// Length prefix, checked against what is left of the file
+        const uint64_t n = get<uint64_t>(is);
+        if (n > (fileSize - static_cast<uint64_t>(is.tellg())) / elementSize)
+            throw std::runtime_error("Truncated checkpoint file");
+        return n;
+    }
+
+    template<typename T>
+    void getVector(std::istream &is, const uint64_t &fileSize, std::vector<T> &v) {
+        v.resize(getLength(is, fileSize, sizeof(T)));
+        if (!is.read(reinterpret_cast<char*>(v.data()), v.size() * sizeof(T)))
+            throw std::runtime_error("Truncated checkpoint file");
+    }
+}
+
+uint64_t resumeHash(const parameters &p) {
+    static const char *runControl[] = { "nReplicates", "nThreads", "chunkThreads", "demeThreads", "asyncOutput", "outputQueueBlocks",
+                                        "resume", "instrumentWindow", "traceFile", "role", "socketPath", "localWorkers", "taskAttempts",
+                                        "sweep", "sweepDesign", "sweepPoints", "fixedSeed", "maxGens", "startPopulation", "bulkInit",
+                                        "savePopulation" };
+    parameters q = p;
+    const parameters defaults;
+    for (const char *key : runControl)
+        setParameter(q, key, getParameter(defaults, key));
+    std::ostringstream config;
+    writeConfig(q, config);
+
+    uint64_t hash = 14695981039346656037ull;			// 64-bit FNV-1a, the same on every platform
+    for (const char ch : config.str()) {
+        hash ^= static_cast<unsigned char>(ch);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+void saveRngState(checkpoint &c) {
+    std::ostringstream os;
+    os << rng;
+    c.rngState = os.str();
+    bulkRng.getState(c.bulkState);
+    c.bulkGenerator = bulkGenerator;
+}
+
+void restoreRngState(const checkpoint &c) {
+    std::istringstream is(c.rngState);
+    is >> rng;
+    if (!is)
+        throw std::runtime_error("Bad engine state in checkpoint");
+    bulkRng.setState(c.bulkState);
+    bulkGenerator = c.bulkGenerator;
+}
+
+void writeCheckpoint(const std::string &fileName, const checkpoint &c) {
+    const std::string tmpName = fileName + ".tmp";
+    {
+        std::ofstream ofs(tmpName, std::ios::binary);
+        if (!ofs.is_open())
+            throw std::runtime_error("Cannot write checkpoint " + tmpName);
+        ofs.write(magic, sizeof(magic));
+        put<uint32_t>(ofs, byteOrderMark);
+        put<int32_t>(ofs, c.iTime);
+        put<uint64_t>(ofs, c.popSize);
+        put<uint64_t>(ofs, c.parameterHash);
+        put<uint8_t>(ofs, static_cast<uint8_t>(c.bulkGenerator));
+        ofs.write(reinterpret_cast<const char*>(c.bulkState), sizeof(c.bulkState));
+        put<uint64_t>(ofs, c.rngState.size());
+        ofs.write(c.rngState.data(), c.rngState.size());
+        putVector(ofs, c.outputSizes);
+
+        const herd &h = c.vHerd;
+        putVector(ofs, h.age);
+        putVector(ofs, h.damageTrait1);
+        putVector(ofs, h.damageTrait2);
+        putVector(ofs, h.gen1);
+        putVector(ofs, h.gen2);
+        putVector(ofs, h.gen3);
+        putVector(ofs, h.alive);
+        putVector(ofs, h.deathCause);
+        if (!c.chunkStates.empty()) {					// Last, so unchunked checkpoints keep their old layout
+            putVector(ofs, c.chunkStates);
+            put<uint64_t>(ofs, c.chunkSize);
+            put<uint32_t>(ofs, c.nDemes);
+        }
+        if (!ofs.flush())
+            throw std::runtime_error("Error writing checkpoint " + tmpName);
+    }
+    std::filesystem::rename(tmpName, fileName);
+}
+
+checkpoint readCheckpoint(const std::string &fileName) {
+    std::ifstream ifs(fileName, std::ios::binary);
+    if (!ifs.is_open())
+        throw std::runtime_error("Cannot open checkpoint " + fileName);
+    char m[sizeof(magic)];
+    if (!ifs.read(m, sizeof(m)) || std::memcmp(m, magic, sizeof(magic)) != 0)
+        throw std::runtime_error(fileName + " is not a checkpoint file");
+    if (get<uint32_t>(ifs) != byteOrderMark)
+        throw std::runtime_error(fileName + " was written on a machine with a different byte order");
+    const uint64_t fileSize = std::filesystem::file_size(fileName);
+
+    checkpoint c;
+    c.iTime = get<int32_t>(ifs);
+    c.popSize = get<uint64_t>(ifs);
+    c.parameterHash = get<uint64_t>(ifs);
+    const uint8_t engine = get<uint8_t>(ifs);
+    if (engine > static_cast<uint8_t>(generator::xoshiro256x4))
+        throw std::runtime_error("Unknown bulk generator in checkpoint " + fileName);
+    c.bulkGenerator = static_cast<generator>(engine);
+    if (!ifs.read(reinterpret_cast<char*>(c.bulkState), sizeof(c.bulkState)))
+        throw std::runtime_error("Truncated checkpoint file");
+    c.rngState.resize(getLength(ifs, fileSize, 1));
+    if (!ifs.read(&c.rngState[0], c.rngState.size()))
+        throw std::runtime_error("Truncated checkpoint file");
+    getVector(ifs, fileSize, c.outputSizes);
+
+    std::vector<int> age;
+    getVector(ifs, fileSize, age);
+    herd &h = c.vHerd;
+    h.resize(age.size());								// Also sizes the scratch buffers
+    h.age = std::move(age);
+    getVector(ifs, fileSize, h.damageTrait1);
+    getVector(ifs, fileSize, h.damageTrait2);
+    getVector(ifs, fileSize, h.gen1);
+    getVector(ifs, fileSize, h.gen2);
+    getVector(ifs, fileSize, h.gen3);
+    getVector(ifs, fileSize, h.alive);
+    getVector(ifs, fileSize, h.deathCause);
+    const size_t n = h.age.size();
+    if (n != c.popSize || h.damageTrait1.size() != n || h.damageTrait2.size() != n || h.gen1.size() != n || h.gen2.size() != n
+        || h.gen3.size() != n || h.alive.size() != n || h.deathCause.size() != n)
+        throw std::runtime_error("Inconsistent herd in checkpoint " + fileName);
+    if (ifs.peek() != std::char_traits<char>::eof()) {
+        getVector(ifs, fileSize, c.chunkStates);
+        c.chunkSize = get<uint64_t>(ifs);
+        c.nDemes = get<uint32_t>(ifs);
+    }
+    return c;
+}
+
+checkpointWriter::~checkpointWriter() {
+    if (writer.joinable())
+        writer.join();
+}
+
+void checkpointWriter::save(const std::string &fileName, checkpoint c) {
+    wait();
+    writer = std::thread([this, fileName, c = std::move(c)]() {
+        try {
+            writeCheckpoint(fileName, c);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+    });
+}
+
+void checkpointWriter::wait() {
+    if (writer.joinable())
+        writer.join();
+    if (error) {
+        std::exception_ptr e = error;
+        error = nullptr;
+        std::rethrow_exception(e);
+    }
+}
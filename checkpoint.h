@@ -0,0 +1,58 @@
+#ifndef MILS_CHECKPOINT_H
+#define MILS_CHECKPOINT_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <cstdint>
+#include "parameters.h"
+#include "herd.h"
+#include "randomnumbers.h"
+
+// Everything needed to continue simulate() bit-identically from the start of generation 'iTime'
+// (also the format of the population files of savePopulation / startPopulation, of which only the herd is used)
+struct checkpoint {
+    int iTime = 0;									// Next generation to simulate
+    unsigned long popSize = 0;						// For checking the resumed run uses the same herd size
+    uint64_t parameterHash = 0;						// resumeHash() of the run that wrote it
+    herd vHerd;
+    std::string rngState;							// Scalar engine (mt19937), in its text representation
+    uint64_t bulkState[16] = {};					// Bulk engine (xoshiro256x4)
+    generator bulkGenerator = generator::xoshiro256x4;
+    std::vector<uint64_t> outputSizes;				// Size of each output file at the checkpoint
+    std::vector<uint64_t> chunkStates;				// Streams of the herd chunks or demes, 16 words each (empty = neither)
+    unsigned long chunkSize = 0;					// Layout the chunk or deme streams belong to (only stored with chunkStates)
+    unsigned int nDemes = 1;
+};
+
+// Hash of every parameter a resumed run must share with the run it continues. Left out are those that cannot change
+// its results: threads, output queueing, instrumentation, the coordinator settings, the sweep, fixedSeed (the engine
+// states are in the checkpoint), maxGens (so a run can be extended), and what only applies at the start or end
+// (startPopulation, bulkInit, savePopulation, resume itself)
+uint64_t resumeHash(const parameters &p);
+
+// Copy the calling thread's engine states into c / restore them from c
+void saveRngState(checkpoint &c);
+void restoreRngState(const checkpoint &c);
+
+// Write c to fileName (via a temporary file and a rename, so a crash never leaves a half-written checkpoint)
+void writeCheckpoint(const std::string &fileName, const checkpoint &c);
+
+// Read a checkpoint; throws std::runtime_error if the file is not a valid checkpoint, is truncated, or its herd columns
+// differ in length from each other or from popSize
+checkpoint readCheckpoint(const std::string &fileName);
+
+//Class def:
+// Writes checkpoints on a background thread, so the simulation only pays for copying its state
+class checkpointWriter {
+public:
+    ~checkpointWriter();
+    void save(const std::string &fileName, checkpoint c);	// Waits for the previous checkpoint to finish, then starts writing c
+    void wait();									// Block until the last checkpoint is on disk; rethrows its error
+
+private:
+    std::thread writer;
+    std::exception_ptr error = nullptr;
+};
+
+#endif //MILS_CHECKPOINT_H
@@ -0,0 +1,119 @@
+#include <cmath>
+#include <vector>
+#include "cohortevents.h"
+#include "herdstats.h"
+#include "randomnumbers.h"
+#include "models.h"
+
+namespace {
+    // Per-timestep totals, indexed by timestep; grown to the last timestep anyone reaches
+    struct timeline {
+        void reach(const size_t &t) {
+            if (t >= aliveDamage1.size()) {
+                aliveDamage1.resize(t + 1, 0.0);
+                aliveDamage2.resize(t + 1, 0.0);
+                deadDamage1.resize(t + 1, 0.0);
+                deadDamage2.resize(t + 1, 0.0);
+                deaths.resize(t + 1, 0);
+                for (std::vector<double> &g : deadGenes)
+                    g.resize(t + 1, 0.0);
+            }
+        }
+
+        std::vector<double> aliveDamage1, aliveDamage2;	// Damage of those alive after the kill of this timestep
+        std::vector<double> deadDamage1, deadDamage2;	// Damage of those that died in this timestep
+        std::vector<long> deaths;
+        std::vector<double> deadGenes[3];
+    };
+}
+
+void runCohortEvents(const parameters &p, herd vHerd, const std::function<void(const cohortStats&)> &onTimestep) {
+    if (vHerd.size() == 0)
+        vHerd = initiatePopulation(p);
+
+    const size_t n = vHerd.size();
+    const long horizon = p.maxGens;									// Stepwise engine stops after this many timesteps
+    std::vector<double> u;
+    fillUniform(u, 3 * n);											// Extrinsic time, intrinsic time and cause, per individual
+    const double logExtSurvival = std::log1p(-p.extDeathRate);
+
+    timeline tl;
+    kahanSum genes[3];
+    long nAlive = 0;
+
+    withModels(p, [&](const auto &mortality1, const auto &mortality2, const auto &allocation) {	// Loop compiled for every combination of laws
+        for (size_t i = 0; i < n; ++i) {
+            if (!vHerd.alive[i])
+                continue;
+            ++nAlive;
+            const double g1 = vHerd.gen1[i], g2 = vHerd.gen2[i], g3 = vHerd.gen3[i];
+            genes[0].add(g1);
+            genes[1].add(g2);
+            genes[2].add(g3);
+
+            long extTime = horizon;										// First timestep in which the extrinsic check fails
+            if (p.extDeathRate >= 1)
+                extTime = 0;
+            else if (p.extDeathRate > 0)
+                extTime = static_cast<long>(std::fmin(std::floor(std::log1p(-u[3 * i]) / logExtSurvival), double(horizon)));
+
+            const double uIntrinsic = 1 - u[3 * i + 1];				// Intrinsic death once the survival drops below this; > 0, so
+            double survival = 1.0;										// that happens long before the product underflows
+            double d1 = vHerd.damageTrait1[i], d2 = vHerd.damageTrait2[i];
+            const double baseDam = p.baseDamage * (1 - g1);
+            long t = 0;
+            int cause = -1;
+            for (; t < horizon; ++t) {
+                double relativeDamage = ((d1 - d2) / (d1 + d2));		// Same maths as herd::addDamage ..
+                double damageAllocation = allocation(g2, g3, relativeDamage);
+                d1 += damageAllocation * baseDam;
+                d2 += (1 - damageAllocation) * baseDam;
+                tl.reach(t);
+                if (t == extTime) {
+                    cause = 0;
+                    break;
+                }
+                double chance1 = mortality1(d1);							// .. and herd::kill
+                double chance2 = mortality2(d2);
+                survival *= (1 - chance1) * (1 - chance2);
+                if (survival < uIntrinsic) {
+                    double pDeath = 1 - (1 - chance1) * (1 - chance2);		// Damage 1 is checked first, so it gets chance1 of the pDeath
+                    cause = u[3 * i + 2] * pDeath < chance1 ? 1 : 2;
+                    break;
+                }
+                tl.aliveDamage1[t] += d1;
+                tl.aliveDamage2[t] += d2;
+            }
+            if (cause >= 0) {
+                tl.deadDamage1[t] += d1;
+                tl.deadDamage2[t] += d2;
+                ++tl.deaths[t];
+                tl.deadGenes[0][t] += g1;
+                tl.deadGenes[1][t] += g2;
+                tl.deadGenes[2][t] += g3;
+            }
+        }
+    });
+
+    cohortStats s;
+    s.time = 0;
+    do {
+        tl.reach(s.time);
+        nAlive -= tl.deaths[s.time];
+        for (int k = 0; k < 3; ++k)
+            genes[k].remove(tl.deadGenes[k][s.time]);
+        s.gen1Total = nAlive ? genes[0].value() : 0.0;				// Exactly 0 once all are dead, as in the stepwise engine
+        s.gen2Total = nAlive ? genes[1].value() : 0.0;
+        s.gen3Total = nAlive ? genes[2].value() : 0.0;
+        s.iAlive = nAlive;
+        s.damage1Alive = tl.aliveDamage1[s.time];
+        s.damage2Alive = tl.aliveDamage2[s.time];
+        s.iDead = tl.deaths[s.time];
+        s.damage1Dead = tl.deadDamage1[s.time];
+        s.damage2Dead = tl.deadDamage2[s.time];
+
+        onTimestep(s);
+
+        ++s.time;
+    } while (s.iAlive > 0 && s.time < p.maxGens);
+}
@@ -0,0 +1,21 @@
+#ifndef MILS_COHORTEVENTS_H
+#define MILS_COHORTEVENTS_H
+
+#include <functional>
+#include "parameters.h"
+#include "herd.h"
+#include "simulation.h"
+
+// Time-to-death engine for a single cohort (cohortEngine = events). Without reproduction an individual's damage
+// trajectory is deterministic given its genes, so instead of re-rolling survival for the whole herd every timestep,
+// each individual's time and cause of death are sampled directly:
+// - extrinsic death time is geometric, drawn by inversion from one uniform;
+// - intrinsic death time is found by walking the Gompertz hazard of both damage traits until the cumulative
+//   survival probability drops below a second uniform (inverse CDF), stopping early at the extrinsic time;
+// - an intrinsic death is put down to damage 1 or 2 with the same conditional odds as herd::kill.
+// The per-timestep rows are then aggregated from these events. Cost is the summed lifetime of the cohort instead of
+// herd size times the lifetime of the last survivor, and the output has the same distribution as runCohort's stepwise
+// engine, though not the same random numbers.
+void runCohortEvents(const parameters &p, herd vHerd, const std::function<void(const cohortStats&)> &onTimestep);
+
+#endif //MILS_COHORTEVENTS_H
@@ -0,0 +1,381 @@
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <deque>
+#include <algorithm>
+#include <set>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "distributed.h"
+#include "simulation.h"
+#include "sweep.h"
+#include "randomnumbers.h"
+
+// Protocol: text lines over the socket.
+//   worker -> coordinator:  hello <pid>
+//   coordinator -> worker:  config <n>, followed by n lines of writeConfig output
+//   coordinator -> worker:  replicate <i> <seed> <resume>  |  point <i> <seed> <value per swept parameter>  |  quit
+//   worker -> coordinator:  row <i> <cohortStats fields>  (sweep points, one per timestep), then done <i>  |  failed <i> <message>
+// A task that fails with an error is not retried: it would fail the same way on any worker.
+
+namespace {
+    //Class def:
+    // One end of a connection, read and written in whole lines
+    class lineChannel {
+    public:
+        explicit lineChannel(const int &fd) : fd(fd) {}
+        ~lineChannel() { ::close(fd); }
+        lineChannel(const lineChannel&) = delete;
+        lineChannel& operator=(const lineChannel&) = delete;
+
+        int descriptor() const { return fd; }
+
+        bool send(const std::string &text) {			// False when the other end is gone
+            size_t sent = 0;
+            while (sent < text.size()) {
+                ssize_t n = ::send(fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0)
+                    return false;
+                sent += static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        bool fill() {									// One read into the buffer; false at end of stream
+            char data[65536];
+            ssize_t n;
+            do
+                n = ::read(fd, data, sizeof(data));
+            while (n < 0 && errno == EINTR);
+            if (n <= 0)
+                return false;
+            buffer.append(data, static_cast<size_t>(n));
+            return true;
+        }
+
+        bool nextLine(std::string &line) {				// Next whole line already in the buffer
+            size_t eol = buffer.find('\n', start);
+            if (eol == std::string::npos) {
+                buffer.erase(0, start);
+                start = 0;
+                return false;
+            }
+            line.assign(buffer, start, eol - start);
+            start = eol + 1;
+            return true;
+        }
+
+        bool receive(std::string &line) {				// Wait for the next line; false at end of stream
+            while (!nextLine(line))
+                if (!fill())
+                    return false;
+            return true;
+        }
+
+    private:
+        int fd;
+        std::string buffer;
+        size_t start = 0;								// Start of the unread part of 'buffer'
+    };
+
+    struct task {
+        bool replicate;									// Else a sweep point
+        unsigned int seed;
+        std::vector<double> point;						// Values of the swept parameters
+        int attempts = 0;
+        bool done = false;
+    };
+
+    struct socketFile {									// Removes the socket when the coordinator ends, also on errors
+        std::string path;
+        ~socketFile() { ::unlink(path.c_str()); }
+    };
+
+    struct workerLink {
+        std::unique_ptr<lineChannel> channel;
+        long pid = 0;
+        int task = -1;									// Task it is running; -1 = idle
+    };
+
+    sockaddr_un socketAddress(const std::string &path) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(address.sun_path))
+            throw std::invalid_argument("socketPath must have 1 to " + std::to_string(sizeof(address.sun_path) - 1) + " characters");
+        std::strcpy(address.sun_path, path.c_str());
+        return address;
+    }
+
+    std::string number(const double &x) {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.17g", x);	// Reads back exactly
+        return text;
+    }
+
+    std::string formatRow(const int &i, const cohortStats &s) {
+        return "row " + std::to_string(i) + " " + std::to_string(s.time) + " " + number(s.gen1Total) + " " + number(s.gen2Total) + " " + number(s.gen3Total)
+            + " " + std::to_string(s.iAlive) + " " + number(s.damage1Alive) + " " + number(s.damage2Alive)
+            + " " + std::to_string(s.iDead) + " " + number(s.damage1Dead) + " " + number(s.damage2Dead) + "\n";
+    }
+
+    bool parseRow(std::istream &is, cohortStats &s) {
+        return static_cast<bool>(is >> s.time >> s.gen1Total >> s.gen2Total >> s.gen3Total >> s.iAlive >> s.damage1Alive >> s.damage2Alive
+                                    >> s.iDead >> s.damage1Dead >> s.damage2Dead);
+    }
+
+    pid_t startWorker(const std::string &socketPath) {
+        const std::string socketArgument = "socketPath=" + socketPath;
+        pid_t pid = ::fork();
+        if (pid == 0) {
+            ::execl("/proc/self/exe", "mils", "role=worker", socketArgument.c_str(), static_cast<char*>(nullptr));
+            ::_exit(127);
+        }
+        if (pid < 0)
+            throw std::runtime_error(std::string("Cannot start a worker: ") + std::strerror(errno));
+        return pid;
+    }
+}
+
+void runCoordinator(const parameters &p, const unsigned int &masterSeed) {
+    std::vector<task> tasks;
+    std::vector<sweepDimension> dims;
+    std::vector<std::vector<double>> design;
+    if (p.sweep.empty())
+        for (int i = 0; i < p.nReplicates; ++i)
+            tasks.push_back({ true, replicateSeed(masterSeed, i), {} });
+    else {
+        dims = parseSweep(p.sweep);
+        design = sweepDesign(p, dims, masterSeed);
+        for (size_t i = 0; i < design.size(); ++i)
+            tasks.push_back({ false, replicateSeed(masterSeed, static_cast<int>(i)), design[i] });
+    }
+    std::vector<std::vector<cohortStats>> results(tasks.size());
+
+    std::ostringstream config;
+    writeConfig(p, config);
+    const std::string configText = config.str();
+    const std::string configMessage = "config " + std::to_string(std::count(configText.begin(), configText.end(), '\n')) + "\n" + configText;
+
+    const sockaddr_un address = socketAddress(p.socketPath);
+    const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+        throw std::runtime_error(std::string("Cannot create a socket: ") + std::strerror(errno));
+    lineChannel listening(listener);							// Closes it on every way out
+    ::unlink(p.socketPath.c_str());							// Left behind by an earlier coordinator
+    if (::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listener, 64) != 0)
+        throw std::runtime_error("Cannot listen on " + p.socketPath + ": " + std::strerror(errno));
+    socketFile removeSocket{ p.socketPath };
+
+    std::set<pid_t> children;
+    size_t spawnBudget = p.localWorkers + tasks.size() * std::max(p.taskAttempts, 1);	// Replacements for workers that die, bounded
+    for (unsigned int k = 0; k < p.localWorkers; ++k, --spawnBudget)
+        children.insert(startWorker(p.socketPath));
+    std::cout << "Coordinator: " + std::to_string(tasks.size()) + " tasks, waiting for workers on " + p.socketPath + "\n";
+
+    std::deque<int> queue;
+    for (size_t i = 0; i < tasks.size(); ++i)
+        queue.push_back(static_cast<int>(i));
+    std::vector<workerLink> workers;
+    size_t nDone = 0;
+
+    auto lose = [&](workerLink &w, const std::string &why) {	// Hand its task to another worker
+        if (w.task >= 0) {
+            task &t = tasks[w.task];
+            results[w.task].clear();
+            if (t.attempts >= std::max(p.taskAttempts, 1))
+                throw std::runtime_error("Task " + std::to_string(w.task) + " lost on " + std::to_string(t.attempts) + " workers; giving up");
+            std::cout << "Coordinator: worker " + std::to_string(w.pid) + " " + why + " during task " + std::to_string(w.task) + "; handing it out again\n";
+            queue.push_front(w.task);
+            w.task = -1;
+        }
+        w.channel.reset();
+    };
+
+    while (nDone < tasks.size()) {
+        for (pid_t pid; (pid = ::waitpid(-1, nullptr, WNOHANG)) > 0; ) {	// Replace local workers that died
+            children.erase(pid);
+            if (spawnBudget > 0) {
+                children.insert(startWorker(p.socketPath));
+                --spawnBudget;
+            }
+        }
+        if (p.localWorkers > 0 && children.empty() && workers.empty())
+            throw std::runtime_error("All local workers failed to start");
+
+        for (workerLink &w : workers) {							// Hand out tasks to idle workers
+            if (!w.channel || w.task >= 0 || queue.empty())
+                continue;
+            const int i = queue.front();
+            task &t = tasks[i];
+            std::string message;
+            if (t.replicate)
+                message = "replicate " + std::to_string(i) + " " + std::to_string(t.seed) + " " + std::to_string(t.attempts > 0 && p.checkpointInterval > 0 ? 1 : p.resume) + "\n";
+            else {
+                message = "point " + std::to_string(i) + " " + std::to_string(t.seed);
+                for (const double &x : t.point)
+                    message += " " + number(x);
+                message += "\n";
+            }
+            queue.pop_front();
+            w.task = i;
+            ++t.attempts;
+            if (!w.channel->send(message))
+                lose(w, "went away");
+        }
+
+        std::vector<pollfd> fds = { { listener, POLLIN, 0 } };
+        std::vector<workerLink*> polled;
+        for (workerLink &w : workers)
+            if (w.channel) {
+                fds.push_back({ w.channel->descriptor(), POLLIN, 0 });
+                polled.push_back(&w);
+            }
+        if (::poll(fds.data(), fds.size(), 200) < 0 && errno != EINTR)
+            throw std::runtime_error(std::string("poll failed: ") + std::strerror(errno));
+
+        for (size_t k = 0; k < polled.size(); ++k) {
+            workerLink &w = *polled[k];
+            if (!(fds[k + 1].revents & (POLLIN | POLLHUP | POLLERR)))
+                continue;
+            if (!w.channel->fill()) {
+                lose(w, "disconnected");
+                continue;
+            }
+            std::string line;
+            while (w.channel && w.channel->nextLine(line)) {
+                std::istringstream is(line);
+                std::string word;
+                int i = -1;
+                is >> word;
+                if (word == "hello")
+                    is >> w.pid;
+                else if (!(is >> i) || i != w.task)
+                    lose(w, "sent an unexpected message");
+                else if (word == "row") {
+                    cohortStats s;
+                    if (!parseRow(is, s))
+                        lose(w, "sent a bad row");
+                    else
+                        results[i].push_back(s);
+                }
+                else if (word == "done") {
+                    tasks[i].done = true;
+                    w.task = -1;
+                    ++nDone;
+                    std::cout << "Coordinator: task " + std::to_string(i) + " done by worker " + std::to_string(w.pid)
+                                 + " (" + std::to_string(nDone) + "/" + std::to_string(tasks.size()) + ")\n";
+                }
+                else if (word == "failed") {
+                    std::string message;
+                    std::getline(is >> std::ws, message);
+                    throw std::runtime_error("Task " + std::to_string(i) + " failed on worker " + std::to_string(w.pid) + ": " + message);
+                }
+                else
+                    lose(w, "sent an unexpected message");
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {							// New worker: send it the configuration
+            const int fd = ::accept(listener, nullptr, nullptr);
+            if (fd >= 0) {
+                workers.push_back({ std::make_unique<lineChannel>(fd), 0, -1 });
+                if (!workers.back().channel->send(configMessage))
+                    workers.back().channel.reset();
+            }
+        }
+        workers.erase(std::remove_if(workers.begin(), workers.end(), [](const workerLink &w) { return !w.channel; }), workers.end());
+    }
+
+    for (workerLink &w : workers)
+        w.channel->send("quit\n");
+    workers.clear();
+    for (pid_t pid : children)
+        ::waitpid(pid, nullptr, 0);
+
+    if (!p.sweep.empty())
+        writeSweep(p, dims, design, results);
+}
+
+void runWorker(const parameters &local) {
+    const sockaddr_un address = socketAddress(local.socketPath);
+    int fd = -1;
+    for (int attempt = 0; fd < 0; ++attempt) {				// The coordinator may still be starting
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+            throw std::runtime_error(std::string("Cannot create a socket: ") + std::strerror(errno));
+        if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            ::close(fd);
+            fd = -1;
+            if (attempt == 100)
+                throw std::runtime_error("No coordinator on " + local.socketPath);
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+    lineChannel channel(fd);
+    if (!channel.send("hello " + std::to_string(::getpid()) + "\n"))
+        return;
+
+    parameters p;
+    std::vector<sweepDimension> dims;
+    std::string line;
+    while (channel.receive(line)) {							// Ends quietly when the coordinator goes away
+        std::istringstream is(line);
+        std::string word;
+        is >> word;
+        if (word == "config") {
+            int nLines = 0;
+            is >> nLines;
+            std::ostringstream text;
+            for (int k = 0; k < nLines && channel.receive(line); ++k)
+                text << line << '\n';
+            std::istringstream configText(text.str());
+            p = parameters();
+            readConfig(p, configText, "coordinator configuration");
+            p.role = "worker";
+            dims = p.sweep.empty() ? std::vector<sweepDimension>() : parseSweep(p.sweep);
+        }
+        else if (word == "replicate" || word == "point") {
+            int i, resume = 0;
+            unsigned int seed;
+            is >> i >> seed;
+            std::string reply;
+            try {
+                if (word == "replicate") {
+                    is >> resume;
+                    parameters r = p;
+                    r.resume = resume;
+                    seedRng(seed, r.bulkGenerator);
+                    simulate(r, r.outputName + std::to_string(i));
+                }
+                else {
+                    std::vector<double> point(dims.size());
+                    for (double &x : point)
+                        is >> x;
+                    for (const cohortStats &s : runSweepPoint(p, dims, point, seed))
+                        reply += formatRow(i, s);
+                }
+                reply += "done " + std::to_string(i) + "\n";
+            }
+            catch (const std::exception &error) {
+                std::string message = error.what();
+                std::replace(message.begin(), message.end(), '\n', ' ');
+                reply = "failed " + std::to_string(i) + " " + message + "\n";
+            }
+            if (!channel.send(reply))
+                return;
+        }
+        else if (word == "quit")
+            return;
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef MILS_DISTRIBUTED_H
+#define MILS_DISTRIBUTED_H
+
+#include "parameters.h"
+
+// Replicates and sweep points spread over processes on one machine (role = coordinator / worker). The coordinator
+// turns the run into tasks, one per replicate or per design point of the sweep, and listens on the Unix socket
+// 'socketPath'. Workers connect, receive the coordinator's configuration, and take one task at a time:
+// - a replicate runs simulate() in the worker, which writes its output files into the worker's working directory;
+// - a sweep point runs its cohort and sends the rows back, and the coordinator writes the Sweep_ table as runSweep does.
+// Every task is seeded as in a local run (replicateSeed(masterSeed, i)), so the output is the same as with role = local,
+// whatever the number of workers or the order tasks finish in. When a worker's connection drops before its task is done,
+// the task is handed out again (a replicate resumes from its checkpoint when checkpointInterval is set), at most
+// taskAttempts times in all. With localWorkers > 0 the coordinator starts that many workers itself and replaces those
+// that die; more can be started by hand with "role=worker socketPath=<path>" from the same working directory.
+
+void runCoordinator(const parameters &p, const unsigned int &masterSeed);	// Run all tasks of 'p' on workers and collect the results
+void runWorker(const parameters &p);										// Run tasks from the coordinator at p.socketPath until it has none left
+
+#endif //MILS_DISTRIBUTED_H
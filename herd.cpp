@@ -0,0 +1,259 @@
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include "herd.h"
+#include "randomnumbers.h"
+#include "instrumentation.h"
+#include "models.h"
+
+template<typename Storage>
+basicHerd<Storage>::basicHerd(const size_t &n) {
+    resize(n);
+}
+
+template<typename Storage>
+size_t basicHerd<Storage>::memoryBytes() const {
+    return age.capacity() * sizeof(age[0]) + (damageTrait1.capacity() + damageTrait2.capacity() + gen1.capacity() + gen2.capacity() + gen3.capacity()) * sizeof(real)
+        + alive.capacity() + deathCause.capacity() * sizeof(deathCause[0]) + died.capacity() + (uExt.capacity() + u1.capacity() + u2.capacity()) * sizeof(double);
+}
+
+template<typename Storage>
+void basicHerd<Storage>::resize(const size_t &n) {
+    age.resize(n, 0);
+    damageTrait1.resize(n, 0.0001);
+    damageTrait2.resize(n, 0.0001);
+    gen1.resize(n, 0.0);
+    gen2.resize(n, 0.0);
+    gen3.resize(n, 0.0);
+    alive.resize(n, 1);
+    deathCause.resize(n, -1);
+    died.resize(n, 0);
+    if (Storage::killBlock == 0) {				// Full size, for the kill of a range of slots
+        uExt.resize(n);
+        u1.resize(n);
+        u2.resize(n);
+    }
+}
+
+template<typename Storage>
+void basicHerd<Storage>::initiate(const parameters &p) {
+    if (p.bulkInit) {
+        const size_t block = 65536;						// Slots per bulk draw, so the normals take no memory per individual
+        std::vector<double> z;
+        for (size_t begin = 0; begin < size(); begin += block) {
+            const size_t n = std::min(block, size() - begin);
+            fillNormal(z, 3 * n);						// Gen 1, 2 and 3 of the block, one column after the other
+            for (size_t i = 0; i < n; ++i) {
+                double g1 = p.gen1Mean + p.gen1StdDev * z[i];
+                gen1[begin + i] = g1 < 0 ? 0 : (g1 > 1 ? 1 : g1);	// Gen 1 is restricted to be between 0 and 1
+            }
+            for (size_t i = 0; i < n; ++i)
+                gen2[begin + i] = p.gen2Mean + p.gen2StdDev * z[n + i];
+            for (size_t i = 0; i < n; ++i)
+                gen3[begin + i] = p.gen3Mean + p.gen3StdDev * z[2 * n + i];
+        }
+    }
+    else {
+        for (size_t i = 0; i < size(); ++i) {			// One normal() per gene, in the order of sheep::setGen1/2/3
+            double g1 = normal(p.gen1Mean, p.gen1StdDev);
+            gen1[i] = g1 < 0 ? 0 : (g1 > 1 ? 1 : g1);
+            gen2[i] = normal(p.gen2Mean, p.gen2StdDev);
+            gen3[i] = normal(p.gen3Mean, p.gen3StdDev);
+        }
+    }
+    std::fill(age.begin(), age.end(), 0);
+    std::fill(damageTrait1.begin(), damageTrait1.end(), 0.0001);
+    std::fill(damageTrait2.begin(), damageTrait2.end(), 0.0001);
+    std::fill(alive.begin(), alive.end(), 1);
+    std::fill(deathCause.begin(), deathCause.end(), -1);
+    std::fill(died.begin(), died.end(), 0);
+}
+
+template<typename Storage>
+void basicHerd<Storage>::setSheep(const size_t &i, const sheep &Sheep) {
+    sheep s = Sheep;							// sheep getters are non-const
+    age[i] = s.getAge();
+    damageTrait1[i] = s.getDamageTrait1();
+    damageTrait2[i] = s.getDamageTrait2();
+    gen1[i] = s.getGen1();
+    gen2[i] = s.getGen2();
+    gen3[i] = s.getGen3();
+    alive[i] = s.isAlive();
+    deathCause[i] = s.getDeathCause();
+    died[i] = 0;
+}
+
+template<typename Storage>
+void basicHerd<Storage>::addDamage(const parameters &p) {
+    addDamage(p, 0, size());
+}
+
+template<typename Storage>
+void basicHerd<Storage>::addDamage(const parameters &p, const size_t &begin, const size_t &end) {
+    withDamage(p, [&](const auto &allocation) { addDamagePass(p, allocation, begin, end); });
+}
+
+template<typename Storage>
+template<typename Damage>
+void basicHerd<Storage>::addDamagePass(const parameters &p, const Damage &allocation, const size_t &begin, const size_t &end) {
+    // Branch-free over all slots so the loop vectorizes; dead individuals receive no damage
+    const size_t n = end;
+    real *d1 = damageTrait1.data(), *d2 = damageTrait2.data();
+    const real *g1 = gen1.data(), *g2 = gen2.data(), *g3 = gen3.data();
+    const char *a = alive.data();
+
+    for (size_t i = begin; i < n; ++i) {
+        double baseDam = p.baseDamage * (1 - g1[i]);					// Initial baseDamage scaled to resources invested in damage prevention
+        double relativeDamage = ((double(d1[i]) - d2[i]) / (double(d1[i]) + d2[i]));
+        double damageAllocation = allocation(g2[i], g3[i], relativeDamage);
+        double mask = a[i] ? 1.0 : 0.0;
+        d1[i] += mask * damageAllocation * baseDam;
+        d2[i] += mask * (1 - damageAllocation) * baseDam;
+    }
+}
+
+template<typename Storage>
+void basicHerd<Storage>::kill(const parameters &p, herdStats *stats) {
+    // Every slot gets three pre-generated uniforms, so the whole pass is branch-free and vectorizes
+    const size_t n = size(), block = Storage::killBlock ? Storage::killBlock : n;
+    if (stats)
+        stats->beginTimestep();
+    for (size_t b = 0; b < n; b += block) {
+        const size_t len = std::min(block, n - b);
+        fillUniform(uExt, len);
+        fillUniform(u1, len);
+        fillUniform(u2, len);
+        killRange(p, stats, b, b + len, b);
+    }
+}
+
+template<typename Storage>
+void basicHerd<Storage>::kill(const parameters &p, herdStats *stats, xoshiro256x4 &engine, const size_t &begin, const size_t &end) {
+    if (Storage::killBlock != 0)				// Ranges of one herd may run at the same time, so they cannot share a block of scratch
+        throw std::logic_error("herd::kill of a range needs full storage");
+    const size_t n = end - begin;
+    MILS_COUNT(counter::rngDraws, 3 * n);
+    engine.fillUniform(uExt.data() + begin, n);
+    engine.fillUniform(u1.data() + begin, n);
+    engine.fillUniform(u2.data() + begin, n);
+    if (stats)
+        stats->beginTimestep();
+    killRange(p, stats, begin, end, 0);
+}
+
+template<typename Storage>
+void basicHerd<Storage>::killRange(const parameters &p, herdStats *stats, const size_t &begin, const size_t &end, const size_t &scratchBegin) {
+    withMortality(p, [&](const auto &mortality1, const auto &mortality2) {
+        if (!stats)
+            this->template killPass<false, false>(p, mortality1, mortality2, stats, begin, end, scratchBegin);
+        else if (stats->gatherDamage)
+            this->template killPass<true, true>(p, mortality1, mortality2, stats, begin, end, scratchBegin);
+        else
+            this->template killPass<true, false>(p, mortality1, mortality2, stats, begin, end, scratchBegin);
+    });
+
+#ifdef MILS_INSTRUMENT
+    uint64_t deaths[3] = {};
+    for (size_t i = begin; i < end; ++i)
+        deaths[died[i] ? deathCause[i] : 0] += died[i];
+    MILS_COUNT(counter::deathsExtrinsic, deaths[0]);
+    MILS_COUNT(counter::deathsDamage1, deaths[1]);
+    MILS_COUNT(counter::deathsDamage2, deaths[2]);
+#endif
+}
+
+template<typename Storage>
+template<bool track, bool trackDamage, typename Mortality>
+void basicHerd<Storage>::killPass(const parameters &p, const Mortality &mortality1, const Mortality &mortality2, herdStats *stats, const size_t &begin, const size_t &end,
+                                  const size_t &scratchBegin) {
+    // With 'track', statistics are gathered in the same pass; that loop no longer vectorizes, but saves a second pass
+    const size_t n = end;
+    const real *d1 = damageTrait1.data(), *d2 = damageTrait2.data();
+    const double *r0 = uExt.data(), *r1 = u1.data(), *r2 = u2.data();
+    char *a = alive.data(), *d = died.data();
+    typename Storage::causeType *cause = deathCause.data();
+
+    for (size_t i = begin; i < n; ++i) {
+        const size_t r = i - scratchBegin;
+        bool ext = r0[r] < p.extDeathRate;											// External deathRate
+        bool intr1 = r1[r] < mortality1(d1[i]);										// Internal death rate for damage 1, e.g. Gompertz law of mortality
+        bool intr2 = r2[r] < mortality2(d2[i]);										// Internal death rate for damage 2
+        int c = ext ? 0 : (intr1 ? 1 : (intr2 ? 2 : -1));						// First check that fails decides the cause, as in sheep::kill
+        bool dies = a[i] && c >= 0;
+        if (track) {
+            if (dies)
+                stats->death(gen1[i], gen2[i], gen3[i], age[i], d1[i], d2[i]);
+            else if (trackDamage && a[i])
+                stats->survivor(d1[i], d2[i]);
+        }
+        d[i] = dies;
+        cause[i] = dies ? c : cause[i];
+        a[i] = a[i] && !dies;
+    }
+}
+
+template<typename Storage>
+void basicHerd<Storage>::advanceAge(herdStats *stats) {
+    advanceAge(stats, 0, size());
+}
+
+template<typename Storage>
+void basicHerd<Storage>::advanceAge(herdStats *stats, const size_t &begin, const size_t &end) {
+    if (sizeof(typename Storage::ageType) < sizeof(int)) {
+        const typename Storage::ageType oldest = std::numeric_limits<typename Storage::ageType>::max();
+        for (size_t i = begin; i < end; ++i)
+            age[i] += alive[i] && age[i] != oldest;		// Saturate instead of wrapping around
+    }
+    else {
+        for (size_t i = begin; i < end; ++i)
+            age[i] += alive[i];
+    }
+    if (stats)
+        stats->advanceAge();
+}
+
+template<typename Storage>
+void basicHerd<Storage>::birth(const size_t &i, const size_t &parent, const double *u, const double *z, const parameters &p) {
+    const double parentGenes[3] = { gen1[parent], gen2[parent], gen3[parent] };
+    birthFrom(i, parentGenes, u, z, p, [](const double &mean, const double &stddev) { return normal(mean, stddev); });
+}
+
+template<typename Storage>
+void basicHerd<Storage>::birth(const size_t &i, const double *parentGenes, const double *u, const double *z, const parameters &p, xoshiro256x4 &engine) {
+    birthFrom(i, parentGenes, u, z, p, [&engine](const double &mean, const double &stddev) {
+        double v[2];											// Box-Muller from the given engine; rare, only for genes of exactly 0
+        engine.fillUniform(v, 2);
+        return mean + stddev * std::sqrt(-2.0 * std::log(1.0 - v[0])) * std::cos(6.283185307179586 * v[1]);
+    });
+}
+
+template<typename Storage>
+template<typename Normal>
+void basicHerd<Storage>::birthFrom(const size_t &i, const double *parentGenes, const double *u, const double *z, const parameters &p, Normal normalDraw) {
+    // Newborn gets the parent's genes (a gene value of exactly 0 is redrawn, as in sheep::setGen*), then may mutate
+    auto clamp01 = [](const double &g) { return g < 0 ? 0.0 : (g > 1 ? 1.0 : g); };	// Gen 1 is restricted to be between 0 and 1
+    double g1 = parentGenes[0] ? parentGenes[0] : clamp01(normalDraw(p.gen1Mean, p.gen1StdDev));
+    double g2 = parentGenes[1] ? parentGenes[1] : normalDraw(p.gen2Mean, p.gen2StdDev);
+    double g3 = parentGenes[2] ? parentGenes[2] : normalDraw(p.gen3Mean, p.gen3StdDev);
+
+    if (u[0] < p.mutationRateGen1)
+        g1 = clamp01(g1 + z[0] * p.gen1MutationstdDev);
+    if (u[1] < p.mutationRateGen2)
+        g2 += z[1] * p.gen2MutationstdDev;
+    if (u[2] < p.mutationRateGen3)
+        g3 += z[2] * p.gen3MutationstdDev;
+
+    gen1[i] = g1;
+    gen2[i] = g2;
+    gen3[i] = g3;
+    age[i] = 0;
+    damageTrait1[i] = 0.0001;
+    damageTrait2[i] = 0.0001;
+    alive[i] = 1;
+    deathCause[i] = -1;
+    died[i] = 0;
+}
+
+template class basicHerd<fullStorage>;
+template class basicHerd<compactStorage>;
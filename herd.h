@@ -0,0 +1,132 @@
+#ifndef MILS_HERD_H
+#define MILS_HERD_H
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include "parameters.h"
+#include "sheep.h"
+#include "herdstats.h"
+#include "randomnumbers.h"
+
+// Column types of a herd. Arithmetic is always done in double; only what is stored differs.
+struct fullStorage {							// The default: double genes and damage
+    using real = double;
+    using ageType = int;
+    using causeType = int;
+    static const size_t killBlock = 0;			// kill() draws its uniforms for the whole herd at once
+};
+struct compactStorage {							// For very large populations: 25 instead of 74 bytes per individual
+    using real = float;
+    using ageType = uint16_t;					// Ages saturate at 65535
+    using causeType = int8_t;
+    static const size_t killBlock = 65536;		// kill() draws its uniforms per block of slots, so they take no memory per individual
+};
+
+template<typename Storage> class basicSheepRef;
+
+//Class def:
+// Structure-of-arrays storage for a whole population. Every property of an individual lives in its own
+// contiguous column, so the per-timestep passes (addDamage/kill/advanceAge) run as tight loops over plain arrays.
+// The column types come from 'Storage'; 'herd' is the double precision one, 'compactHerd' the compact one.
+template<typename Storage>
+class basicHerd {
+public:
+    using real = typename Storage::real;
+
+    basicHerd(const size_t &n = 0);				// Herd of n slots; use initiate() or setSheep() to fill them
+    template<typename Other>
+    explicit basicHerd(const basicHerd<Other> &other);	// Same individuals in other column types
+
+    size_t size() const { return age.size(); }
+    size_t memoryBytes() const;					// Heap memory of all columns and scratch buffers
+    void resize(const size_t &n);
+    void initiate(const parameters &p);			// Newborns in every slot, genes from the normal distributions of p (bulk draws unless p.bulkInit = 0)
+    void setSheep(const size_t &i, const sheep &Sheep);	// Copy an individual into slot i
+    basicSheepRef<Storage> operator[](const size_t &i);	// Per-individual view with the sheep getters, for existing callers
+
+    //Batch kernels, applied to every living individual, with the laws selected in p (see models.h)
+    void addDamage(const parameters &p);		// Same maths as sheep::addDamage
+    void kill(const parameters &p, herdStats *stats = nullptr);	// Same maths as sheep::kill, with pre-generated uniforms; fills 'died'.
+                                                                // Also feeds deaths and survivors' damage to 'stats', if given
+    void advanceAge(herdStats *stats = nullptr);	// +1 age for every survivor
+    void birth(const size_t &i, const size_t &parent, const double *u, const double *z, const parameters &p);	// Newborn in slot i with parent's genes,
+                                                                                                            // mutated using 3 uniforms u and 3 standard normals z
+
+    //Same kernels on slots [begin, end) only, drawing from a given engine; disjoint ranges may run on different threads at once
+    void addDamage(const parameters &p, const size_t &begin, const size_t &end);
+    void kill(const parameters &p, herdStats *stats, xoshiro256x4 &engine, const size_t &begin, const size_t &end);	// Full storage only
+    void advanceAge(herdStats *stats, const size_t &begin, const size_t &end);
+    void birth(const size_t &i, const double *parentGenes, const double *u, const double *z, const parameters &p, xoshiro256x4 &engine);	// Parent's 3 genes given
+
+    //Columns
+    std::vector<typename Storage::ageType> age;	// Current age of individual
+    std::vector<real> damageTrait1;				// Damage accumulated in component 1
+    std::vector<real> damageTrait2;				// Damage accumulated in component 2
+    std::vector<real> gen1;						// Allocation of resources towards repair (repair resources = gen1, offspring resources = 1 - gen1)
+    std::vector<real> gen2;						// Allocation of repair-resources towards repair of damage1
+    std::vector<real> gen3;						// Allocation of incoming damage when both damages are equal
+    std::vector<char> alive;					// 1 if alive, 0 if dead
+    std::vector<typename Storage::causeType> deathCause;	// 0 extrinsic, 1 damage 1, 2 damage 2, -1 alive
+    std::vector<char> died;						// 1 if individual died in the last call to kill()
+
+private:
+    template<typename Damage>
+    void addDamagePass(const parameters &p, const Damage &allocation, const size_t &begin, const size_t &end);
+    template<bool track, bool trackDamage, typename Mortality>
+    void killPass(const parameters &p, const Mortality &mortality1, const Mortality &mortality2, herdStats *stats, const size_t &begin, const size_t &end,
+                  const size_t &scratchBegin);
+    void killRange(const parameters &p, herdStats *stats, const size_t &begin, const size_t &end, const size_t &scratchBegin);	// Uniforms of slot i already
+                                                                                                                            // drawn, at i - scratchBegin
+    template<typename Normal>
+    void birthFrom(const size_t &i, const double *parentGenes, const double *u, const double *z, const parameters &p, Normal normalDraw);
+
+    std::vector<double> uExt;					// Scratch: uniforms for the extrinsic / damage 1 / damage 2 death checks (a block of slots in compact storage)
+    std::vector<double> u1;
+    std::vector<double> u2;
+};
+
+using herd = basicHerd<fullStorage>;
+using compactHerd = basicHerd<compactStorage>;
+
+// Lightweight reference to one individual in a herd, exposing the sheep getters
+template<typename Storage>
+class basicSheepRef {
+public:
+    basicSheepRef(basicHerd<Storage> &h, const size_t &i) : h(h), i(i) {}
+
+    double getGen1() const { return h.gen1[i]; }
+    double getGen2() const { return h.gen2[i]; }
+    double getGen3() const { return h.gen3[i]; }
+    int getAge() const { return h.age[i]; }
+    bool isAlive() const { return h.alive[i] != 0; }
+    double getRepairResources() const { return h.gen1[i]; }
+    double getOffspringResources() const { return 1 - h.gen1[i]; }
+    double getDamageTrait1() const { return h.damageTrait1[i]; }
+    double getDamageTrait2() const { return h.damageTrait2[i]; }
+    int getDeathCause() const { return h.deathCause[i]; }
+
+private:
+    basicHerd<Storage> &h;
+    size_t i;
+};
+
+template<typename Storage>
+inline basicSheepRef<Storage> basicHerd<Storage>::operator[](const size_t &i) { return basicSheepRef<Storage>(*this, i); }
+
+template<typename Storage>
+template<typename Other>
+basicHerd<Storage>::basicHerd(const basicHerd<Other> &other) {
+    resize(other.size());
+    std::copy(other.age.begin(), other.age.end(), age.begin());
+    std::copy(other.damageTrait1.begin(), other.damageTrait1.end(), damageTrait1.begin());
+    std::copy(other.damageTrait2.begin(), other.damageTrait2.end(), damageTrait2.begin());
+    std::copy(other.gen1.begin(), other.gen1.end(), gen1.begin());
+    std::copy(other.gen2.begin(), other.gen2.end(), gen2.begin());
+    std::copy(other.gen3.begin(), other.gen3.end(), gen3.begin());
+    std::copy(other.alive.begin(), other.alive.end(), alive.begin());
+    std::copy(other.deathCause.begin(), other.deathCause.end(), deathCause.begin());
+    std::copy(other.died.begin(), other.died.end(), died.begin());
+}
+
+#endif //MILS_HERD_H
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <stdexcept>
+#include "herdchunks.h"
+#include "simulation.h"
+
+namespace {
+    unsigned int poolSize(const parameters &p, const size_t &nChunks) {
+        unsigned int n = p.chunkThreads ? p.chunkThreads : std::max(1u, std::thread::hardware_concurrency());
+        return static_cast<unsigned int>(std::min<size_t>(n, std::max<size_t>(nChunks, 1)));
+    }
+}
+
+herdChunks::herdChunks(const parameters &p, herd &h)
+    : p(p), h(h), chunks((h.size() + p.chunkSize - 1) / p.chunkSize), chunkWeights(chunks.size()), pool(poolSize(p, chunks.size())) {
+    for (size_t k = 0; k < chunks.size(); ++k) {		// Sized once, for the worst case of the whole chunk dying
+        chunk &c = chunks[k];
+        c.begin = k * p.chunkSize;
+        c.end = std::min(h.size(), c.begin + p.chunkSize);
+        const size_t n = c.end - c.begin;
+        c.stats = herdStats(p);
+        c.offspring.resize(n);
+        c.deadSheep.reserve(n);
+        c.uParent.reserve(2 * n);
+        c.parentGenes.reserve(3 * n);
+        c.uMutate.reserve(3 * n);
+        c.zMutate.reserve(3 * n + 1);					// fillNormal rounds up to whole pairs
+    }
+}
+
+void herdChunks::forEachChunk(std::function<void(chunk&)> stage) {
+    // Tasks count into the calling thread's instrumentation record. They are not timed one by one: the timers of a
+    // record are only safe to use from its own thread, so the caller times the whole stage instead
+    currentStage = std::move(stage);
+    owner = &instrumentation::local();
+    for (chunk &c : chunks) {
+        pool.submit([this, &c]() {
+            if (instrumentationEnabled())
+                instrumentation::reportTo(owner);
+            currentStage(c);
+        });
+    }
+    pool.wait();
+}
+
+void herdChunks::seed() {
+    uint64_t words[4];
+    for (chunk &c : chunks) {
+        bulkRng.next4(words);
+        c.rng.reseed(words[0]);
+    }
+}
+
+void herdChunks::rebuildStats() {
+    forEachChunk([this](chunk &c) {
+        c.stats.rebuild(h, c.begin, c.end);
+    });
+}
+
+void herdChunks::step(const bool &gatherDamage) {
+    forEachChunk([this, gatherDamage](chunk &c) {
+        h.addDamage(p, c.begin, c.end);
+        c.stats.gatherDamage = gatherDamage;
+        h.kill(p, &c.stats, c.rng, c.begin, c.end);
+        h.advanceAge(&c.stats, c.begin, c.end);
+
+        c.deadSheep.clear();							// Prepare reproduce(), as in sampleParents
+        c.weight = 0;
+        for (size_t i = c.begin; i < c.end; ++i) {
+            c.offspring[i - c.begin] = offspringWeight(h.gen1[i], p);
+            c.weight += c.offspring[i - c.begin];
+            if (!h.alive[i])
+                c.deadSheep.push_back(static_cast<int>(i));
+        }
+        c.parents.build(c.offspring);
+    });
+}
+
+void herdChunks::mergeStats(herdStats &total) const {
+    total.clear();
+    for (const chunk &c : chunks)
+        total.add(c.stats);
+}
+
+void herdChunks::reproduce() {
+    {
+        MILS_TIME(timer::parentSampling);
+        for (size_t k = 0; k < chunks.size(); ++k)
+            chunkWeights[k] = chunks[k].weight;
+        chunkTable.build(chunkWeights);
+        forEachChunk([this](chunk &c) {					// Draw all parents before any birth overwrites a slot
+            const size_t nDead = c.deadSheep.size();
+            fillUniform(c.rng, c.uParent, 2 * nDead);
+            c.parentGenes.resize(3 * nDead);
+            for (size_t j = 0; j < nDead; ++j) {
+                const chunk &from = chunks[chunkTable.draw(c.uParent[2 * j])];
+                const size_t parent = from.begin + from.parents.draw(c.uParent[2 * j + 1]);
+                c.parentGenes[3 * j] = h.gen1[parent];
+                c.parentGenes[3 * j + 1] = h.gen2[parent];
+                c.parentGenes[3 * j + 2] = h.gen3[parent];
+            }
+        });
+    }
+    MILS_TIME(timer::mutation);
+    forEachChunk([this](chunk &c) {
+        const size_t nDead = c.deadSheep.size();
+        fillUniform(c.rng, c.uMutate, 3 * nDead);
+        fillNormal(c.rng, c.zMutate, 3 * nDead);
+        MILS_COUNT(counter::births, nDead);
+        for (size_t j = 0; j < nDead; ++j) {
+            const int i = c.deadSheep[j];
+            h.birth(i, &c.parentGenes[3 * j], &c.uMutate[3 * j], &c.zMutate[3 * j], p, c.rng);
+            c.stats.birth(h.gen1[i], h.gen2[i], h.gen3[i]);
+        }
+    });
+}
+
+std::vector<uint64_t> herdChunks::getStates() const {
+    std::vector<uint64_t> states(16 * chunks.size());
+    for (size_t k = 0; k < chunks.size(); ++k)
+        chunks[k].rng.getState(&states[16 * k]);
+    return states;
+}
+
+void herdChunks::setStates(const std::vector<uint64_t> &states) {
+    if (states.size() != 16 * chunks.size())
+        throw std::runtime_error("Checkpoint has " + std::to_string(states.size() / 16) + " chunk streams, expected " + std::to_string(chunks.size()));
+    for (size_t k = 0; k < chunks.size(); ++k)
+        chunks[k].rng.setState(&states[16 * k]);
+}
@@ -0,0 +1,68 @@
+#ifndef MILS_HERDCHUNKS_H
+#define MILS_HERDCHUNKS_H
+
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include "parameters.h"
+#include "herd.h"
+#include "herdstats.h"
+#include "randomnumbers.h"
+#include "threadpool.h"
+#include "instrumentation.h"
+
+//Class def:
+// Parallel generation step for one replicate (chunkSize > 0). The herd is cut into fixed chunks of 'chunkSize' slots,
+// and every chunk owns its own random stream, statistics and reproduction buffers, so the chunks of one stage run on a
+// persistent thread pool without sharing anything they write:
+// - step(): addDamage, kill and advanceAge of the chunk, then its offspring weights, alias table and list of dead slots;
+// - reproduce(): a top-level alias table over the chunks' summed weights is built serially. Then every chunk draws a
+//   parent for each of its dead slots (chunk from the top table, slot from that chunk's table) and copies the parent's
+//   genes; after a barrier, every chunk fills its dead slots with the mutated offspring.
+// Which chunk does what, and which random numbers it uses, never depends on the thread that runs it, and statistics are
+// merged in chunk order, so the output is the same for any chunkThreads. It is not the same as the unchunked run:
+// the random streams differ, and all parents are read as they were before this generation's births.
+class herdChunks {
+public:
+    herdChunks(const parameters &p, herd &h);
+
+    size_t size() const { return chunks.size(); }
+    void seed();									// Seed every chunk's stream from the calling thread's bulk engine
+    void rebuildStats();							// herdStats::rebuild of every chunk
+    void step(const bool &gatherDamage);			// One timestep of damage, deaths and ageing; prepares reproduce()
+    void mergeStats(herdStats &total) const;		// Statistics of the whole herd, combined in chunk order
+    void reproduce();								// Replace the dead by offspring
+
+    std::vector<uint64_t> getStates() const;		// Stream states of all chunks, 16 words each (for checkpoints)
+    void setStates(const std::vector<uint64_t> &states);
+
+private:
+    struct chunk {
+        size_t begin, end;							// Slots [begin, end) of the herd
+        xoshiro256x4 rng;
+        herdStats stats;
+        std::vector<double> offspring;				// Offspring weight per slot, and their sum
+        double weight = 0;
+        aliasTable parents;
+        std::vector<int> deadSheep;
+        std::vector<double> uParent;				// 2 per dead slot: chunk and slot of the parent
+        std::vector<double> parentGenes;			// 3 per dead slot
+        std::vector<double> uMutate;
+        std::vector<double> zMutate;
+    };
+
+    void forEachChunk(std::function<void(chunk&)> stage);	// Run stage(chunk&) for every chunk on the pool, and wait
+
+    const parameters &p;
+    herd &h;
+    std::vector<chunk> chunks;
+    std::vector<double> chunkWeights;
+    aliasTable chunkTable;
+    std::function<void(chunk&)> currentStage;		// Tasks capture only this and their chunk, small enough for std::function to hold
+                                                    // without allocating (libstdc++ and libc++ keep up to two pointers inline);
+                                                    // the pool's queues don't allocate either once they have held one stage
+    instrumentation *owner = nullptr;				// Record of the replicate thread, counted into by the tasks
+    threadPool pool;
+};
+
+#endif //MILS_HERDCHUNKS_H
@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <stdexcept>
+#include "herddemes.h"
+#include "simulation.h"
+
+namespace {
+    unsigned int poolSize(const parameters &p, const size_t &nDemes) {
+        unsigned int n = p.demeThreads ? p.demeThreads : std::max(1u, std::thread::hardware_concurrency());
+        return static_cast<unsigned int>(std::min<size_t>(n, std::max<size_t>(nDemes, 1)));
+    }
+
+    void copySlot(const herd &from, const size_t &i, herd &to, const size_t &j) {
+        to.age[j] = from.age[i];
+        to.damageTrait1[j] = from.damageTrait1[i];
+        to.damageTrait2[j] = from.damageTrait2[i];
+        to.gen1[j] = from.gen1[i];
+        to.gen2[j] = from.gen2[i];
+        to.gen3[j] = from.gen3[i];
+        to.alive[j] = from.alive[i];
+        to.deathCause[j] = from.deathCause[i];
+        to.died[j] = from.died[i];
+    }
+}
+
+herdDemes::herdDemes(const parameters &p, herd &h)
+    : p(p), h(h), demes(p.nDemes), statsInterval(std::max(p.statsInterval, 1)), pool(poolSize(p, p.nDemes)) {
+    if (p.nDemes == 0 || p.nDemes > h.size())
+        throw std::invalid_argument("nDemes must be between 1 and popSize");
+    size_t nMigrants = 0;
+    for (size_t k = 0; k < demes.size(); ++k) {			// Sized once, for the worst case of the whole deme dying
+        deme &d = demes[k];
+        d.begin = k * h.size() / demes.size();
+        d.end = (k + 1) * h.size() / demes.size();
+        const size_t n = d.end - d.begin;
+        d.stats = herdStats(p);
+        d.records.assign(maxRecords, d.stats);
+        d.offspring.resize(n);
+        d.deadSheep.reserve(n);
+        d.parentOf.reserve(n);
+        d.uParent.reserve(n);
+        d.uMutate.reserve(3 * n);
+        d.zMutate.reserve(3 * n + 1);					// fillNormal rounds up to whole pairs
+        d.nMigrants = std::min(n, static_cast<size_t>(std::llround(std::max(p.migrationRate, 0.0) * n)));
+        d.order.resize(n);
+        d.uMigrate.reserve(d.nMigrants);
+        nMigrants += d.nMigrants;
+    }
+    migrants.resize(nMigrants);
+    migrantSlots.reserve(nMigrants);
+    uShuffle.reserve(nMigrants);
+}
+
+void herdDemes::forEachDeme(std::function<void(deme&)> stage) {
+    // As herdChunks::forEachChunk: tasks count into the calling thread's instrumentation record, the caller times the stage
+    currentStage = std::move(stage);
+    owner = &instrumentation::local();
+    for (deme &d : demes) {
+        pool.submit([this, &d]() {
+            if (instrumentationEnabled())
+                instrumentation::reportTo(owner);
+            currentStage(d);
+        });
+    }
+    pool.wait();
+}
+
+void herdDemes::seed() {
+    uint64_t words[4];
+    for (deme &d : demes) {
+        bulkRng.next4(words);
+        d.rng.reseed(words[0]);
+    }
+    bulkRng.next4(words);
+    migrationRng.reseed(words[0]);
+}
+
+bool herdDemes::needsHerd(const int &iTime) const {
+    return iTime % snapshotInterval == 0 || iTime + 1 >= p.maxGens
+        || (p.checkpointInterval > 0 && (iTime + 1) % p.checkpointInterval == 0)
+        || (p.migrationInterval > 0 && (iTime + 1) % p.migrationInterval == 0);
+}
+
+void herdDemes::runBatch(const int &first) {
+    if (firstGeneration < 0)
+        firstGeneration = first;
+    int last = first;
+    size_t nRecords = first % statsInterval == 0;
+    while (!needsHerd(last) && (nRecords < maxRecords || (last + 1) % statsInterval != 0)) {
+        ++last;
+        nRecords += last % statsInterval == 0;
+    }
+    batchStart = first;
+    batchEnd = last;
+    nextRecord = 0;
+
+    forEachDeme([this](deme &d) {
+        size_t record = 0;
+        for (int t = batchStart; t <= batchEnd; ++t) {
+            if (t > batchStart)
+                reproduceDeme(d);
+            if (d.rebuild || t == firstGeneration || t % snapshotInterval == 0 || (p.checkpointInterval > 0 && t % p.checkpointInterval == 0)) {
+                d.stats.rebuild(h, d.begin, d.end);	// At the generations where simulate() recounts, and after migrations
+                d.rebuild = false;
+            }
+            const bool written = t % statsInterval == 0;
+            h.addDamage(p, d.begin, d.end);
+            d.stats.gatherDamage = written;
+            h.kill(p, &d.stats, d.rng, d.begin, d.end);
+            h.advanceAge(&d.stats, d.begin, d.end);
+            if (written)
+                d.records[record++] = d.stats;		// Same size, so no allocation
+        }
+    });
+}
+
+void herdDemes::step(const int &iTime, herdStats &total) {
+    if (iTime > batchEnd)
+        runBatch(iTime);
+    if (iTime % statsInterval == 0) {
+        total.clear();
+        for (const deme &d : demes)
+            total.add(d.records[nextRecord]);
+        ++nextRecord;
+    }
+}
+
+void herdDemes::reproduceDeme(deme &d) {
+    // sampleParents and placeOffspring, with parents from the deme only
+    d.deadSheep.clear();
+    for (size_t i = d.begin; i < d.end; ++i) {
+        d.offspring[i - d.begin] = offspringWeight(h.gen1[i], p);
+        if (!h.alive[i])
+            d.deadSheep.push_back(static_cast<int>(i));
+    }
+    d.parents.build(d.offspring);
+
+    const size_t nDead = d.deadSheep.size();
+    fillUniform(d.rng, d.uParent, nDead);
+    d.parentOf.resize(nDead);
+    for (size_t j = 0; j < nDead; ++j)
+        d.parentOf[j] = static_cast<int>(d.begin) + d.parents.draw(d.uParent[j]);
+
+    fillUniform(d.rng, d.uMutate, 3 * nDead);
+    fillNormal(d.rng, d.zMutate, 3 * nDead);
+    MILS_COUNT(counter::births, nDead);
+    for (size_t j = 0; j < nDead; ++j) {
+        const int i = d.deadSheep[j], parent = d.parentOf[j];
+        const double parentGenes[3] = { h.gen1[parent], h.gen2[parent], h.gen3[parent] };
+        h.birth(i, parentGenes, &d.uMutate[3 * j], &d.zMutate[3 * j], p, d.rng);
+        d.stats.birth(h.gen1[i], h.gen2[i], h.gen3[i]);
+    }
+}
+
+void herdDemes::reproduce(const int &iTime) {
+    if (iTime != batchEnd)								// Done already, by runBatch
+        return;
+    {
+        MILS_TIME(timer::mutation);
+        forEachDeme([this](deme &d) { reproduceDeme(d); });
+    }
+    if (p.migrationInterval > 0 && (iTime + 1) % p.migrationInterval == 0 && demes.size() > 1) {
+        MILS_TIME(timer::migration);
+        migrate();
+    }
+}
+
+void herdDemes::migrate() {
+    forEachDeme([this](deme &d) {						// Every deme picks its emigrants
+        const size_t n = d.end - d.begin;
+        fillUniform(d.rng, d.uMigrate, d.nMigrants);
+        std::iota(d.order.begin(), d.order.end(), size_t(0));	// From the same start each time, so a resumed run picks the same
+        for (size_t j = 0; j < d.nMigrants; ++j) {		// Partial Fisher-Yates: a uniform sample of nMigrants slots
+            const size_t k = j + static_cast<size_t>(d.uMigrate[j] * (n - j));
+            std::swap(d.order[j], d.order[std::min(k, n - 1)]);
+        }
+        d.rebuild = true;
+    });
+
+    migrantSlots.clear();								// Pool them in deme order, then deal them out over the vacated slots
+    for (const deme &d : demes)
+        for (size_t j = 0; j < d.nMigrants; ++j)
+            migrantSlots.push_back(d.begin + d.order[j]);
+    const size_t m = migrantSlots.size();
+    for (size_t j = 0; j < m; ++j)
+        copySlot(h, migrantSlots[j], migrants, j);
+    fillUniform(migrationRng, uShuffle, m);
+    for (size_t j = m; j-- > 1; )
+        std::swap(migrantSlots[j], migrantSlots[std::min(static_cast<size_t>(uShuffle[j] * (j + 1)), j)]);
+    for (size_t j = 0; j < m; ++j)
+        copySlot(migrants, j, h, migrantSlots[j]);
+}
+
+std::vector<uint64_t> herdDemes::getStates() const {
+    std::vector<uint64_t> states(16 * (demes.size() + 1));
+    for (size_t k = 0; k < demes.size(); ++k)
+        demes[k].rng.getState(&states[16 * k]);
+    migrationRng.getState(&states[16 * demes.size()]);
+    return states;
+}
+
+void herdDemes::setStates(const std::vector<uint64_t> &states) {
+    if (states.size() != 16 * (demes.size() + 1))
+        throw std::runtime_error("Checkpoint has " + std::to_string(states.size() / 16) + " deme streams, expected " + std::to_string(demes.size() + 1));
+    for (size_t k = 0; k < demes.size(); ++k)
+        demes[k].rng.setState(&states[16 * k]);
+    migrationRng.setState(&states[16 * demes.size()]);
+}
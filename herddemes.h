@@ -0,0 +1,83 @@
+#ifndef MILS_HERDDEMES_H
+#define MILS_HERDDEMES_H
+
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include "parameters.h"
+#include "herd.h"
+#include "herdstats.h"
+#include "randomnumbers.h"
+#include "threadpool.h"
+#include "instrumentation.h"
+
+//Class def:
+// Island model for one replicate (nDemes > 1). The herd is cut into nDemes demes of popSize / nDemes slots, and each
+// deme is a population of its own: parents are drawn only from the deme (with the deme's own alias table), and every
+// deme owns its random stream and statistics. Demes only meet at migrations: every migrationInterval generations a
+// fraction migrationRate of every deme is picked at random, and these migrants are shuffled over the slots they left
+// (a migrant pool; a migrant stays home with chance 1 / nDemes).
+// Between migrations the demes need each other for nothing but the output, so the engine runs ahead: step() runs each
+// deme through all generations up to the next one whose state simulate() needs (a snapshot, checkpoint, migration or
+// the last generation; at most 'maxRecords' rows of statistics), one pool task per deme, and keeps the statistics of
+// the generations that are written out. Calls for the generations in between only merge those statistics, in deme
+// order, so the output is the same for any demeThreads and however the generations were batched.
+class herdDemes {
+public:
+    herdDemes(const parameters &p, herd &h);
+
+    size_t size() const { return demes.size(); }
+    void seed();									// Seed every deme's stream, and the migration stream, from the calling thread's bulk engine
+    void step(const int &iTime, herdStats &total);	// Damage, deaths and ageing of generation iTime; when it is written out,
+                                                    // 'total' gets the statistics of the whole herd
+    void reproduce(const int &iTime);				// Replace the dead by offspring of their deme, then migrate if due
+
+    std::vector<uint64_t> getStates() const;		// Stream states of all demes and of migration, 16 words each (for checkpoints)
+    void setStates(const std::vector<uint64_t> &states);
+
+private:
+    static const size_t maxRecords = 32;			// Rows of statistics kept per deme, which bounds how far step() runs ahead
+
+    struct deme {
+        size_t begin, end;							// Slots [begin, end) of the herd
+        xoshiro256x4 rng;
+        herdStats stats;
+        std::vector<herdStats> records;				// Statistics of the written-out generations of the current batch
+        bool rebuild = false;						// Recount the statistics before the next step (after a migration)
+        std::vector<double> offspring;				// Offspring weight per slot
+        aliasTable parents;
+        std::vector<int> deadSheep;
+        std::vector<int> parentOf;
+        std::vector<double> uParent;
+        std::vector<double> uMutate;
+        std::vector<double> zMutate;
+        size_t nMigrants = 0;
+        std::vector<size_t> order;					// Slots of the deme, shuffled at a migration; the first nMigrants leave
+        std::vector<double> uMigrate;
+    };
+
+    void forEachDeme(std::function<void(deme&)> stage);	// Run stage(deme&) for every deme on the pool, and wait
+    void runBatch(const int &first);				// step() and reproduce() of generations first .. batchEnd - 1, then step() of batchEnd
+    bool needsHerd(const int &iTime) const;			// simulate() looks at the herd during or right after generation iTime
+    void reproduceDeme(deme &d);
+    void migrate();
+
+    const parameters &p;
+    herd &h;
+    std::vector<deme> demes;
+    int firstGeneration = -1;						// Of this run; the statistics are recounted there
+    int batchStart = -1;
+    int batchEnd = -1;
+    size_t nextRecord = 0;							// Record merged by the next step() that writes out
+    const int statsInterval;
+    xoshiro256x4 migrationRng;						// Shuffles the migrant pool
+    herd migrants;									// Scratch for the migrant pool
+    std::vector<size_t> migrantSlots;
+    std::vector<double> uShuffle;
+    std::function<void(deme&)> currentStage;		// Tasks capture only this and their deme, so neither they nor the pool's queues
+                                                    // allocate once the queues have held one stage (see threadPool)
+    instrumentation *owner = nullptr;				// Record of the replicate thread, counted into by the tasks
+    threadPool pool;
+};
+
+#endif //MILS_HERDDEMES_H
@@ -0,0 +1,80 @@
+#include "herdstats.h"
+#include "herd.h"
+
+herdStats::herdStats(const parameters &p) {
+    const size_t bins = p.histogramBins > 0 ? p.histogramBins : 0;
+    genHist[0] = histogram(bins, 0.0, 1.0);		// Gen 1 is restricted to be between 0 and 1
+    genHist[1] = histogram(bins, -p.histogramGeneRange, p.histogramGeneRange);
+    genHist[2] = histogram(bins, -p.histogramGeneRange, p.histogramGeneRange);
+    damageHist[0] = histogram(bins, 0.0, p.histogramDamageMax);
+    damageHist[1] = histogram(bins, 0.0, p.histogramDamageMax);
+}
+
+template<typename Storage>
+void herdStats::rebuild(const basicHerd<Storage> &h) {
+    rebuild(h, 0, h.size());
+}
+
+template<typename Storage>
+void herdStats::rebuild(const basicHerd<Storage> &h, const size_t &begin, const size_t &end) {
+    ageAlive = 0;
+    for (int k = 0; k < 3; ++k) {
+        genAlive[k].clear();
+        genHist[k].clear();
+    }
+    kahanSum damage[2];
+    for (size_t i = begin; i < end; ++i) {
+        if (h.alive[i]) {
+            birth(h.gen1[i], h.gen2[i], h.gen3[i]);
+            ageAlive += h.age[i];
+            damage[0].add(h.damageTrait1[i]);
+            damage[1].add(h.damageTrait2[i]);
+        }
+    }
+    for (int k = 0; k < 2; ++k)					// Shift damage sums by the current means, so they depend only on the herd
+        damageAlive[k].reset(nAlive() > 0 ? damage[k].value() / nAlive() : 0.0);
+}
+
+template void herdStats::rebuild(const herd &h);
+template void herdStats::rebuild(const compactHerd &h);
+template void herdStats::rebuild(const herd &h, const size_t &begin, const size_t &end);
+template void herdStats::rebuild(const compactHerd &h, const size_t &begin, const size_t &end);
+
+void herdStats::clear() {
+    ageAlive = 0;
+    for (int k = 0; k < 3; ++k) {
+        genAlive[k].clear();
+        genHist[k].clear();
+    }
+    for (int k = 0; k < 2; ++k)
+        damageAlive[k].reset(0.0);
+    beginTimestep();
+}
+
+void herdStats::add(const herdStats &other) {
+    ageAlive += other.ageAlive;
+    nDead += other.nDead;
+    ageDead += other.ageDead;
+    for (int k = 0; k < 3; ++k) {
+        genAlive[k].add(other.genAlive[k]);
+        genHist[k].add(other.genHist[k]);
+        genDead[k].add(other.genDead[k]);
+    }
+    for (int k = 0; k < 2; ++k) {
+        damageAlive[k].add(other.damageAlive[k]);
+        damageHist[k].add(other.damageHist[k]);
+        damageDead[k].add(other.damageDead[k]);
+    }
+}
+
+void herdStats::beginTimestep() {
+    nDead = 0;
+    ageDead = 0;
+    for (int k = 0; k < 3; ++k)
+        genDead[k].clear();
+    for (int k = 0; k < 2; ++k) {
+        damageAlive[k].begin();
+        damageDead[k].clear();
+        damageHist[k].clear();
+    }
+}
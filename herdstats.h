@@ -0,0 +1,218 @@
+#ifndef MILS_HERDSTATS_H
+#define MILS_HERDSTATS_H
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "parameters.h"
+
+template<typename Storage> class basicHerd;
+
+// Compensated sum (Neumaier's variant of Kahan summation); values can be taken out again with remove()
+class kahanSum {
+public:
+    void add(const double &x) {
+        double t = sum + x;
+        c += std::fabs(sum) >= std::fabs(x) ? (sum - t) + x : (x - t) + sum;
+        sum = t;
+    }
+    void remove(const double &x) { add(-x); }
+    void add(const kahanSum &other) { add(other.sum); add(other.c); }
+    void clear() { sum = c = 0.0; }
+    double value() const { return sum + c; }
+
+private:
+    double sum = 0.0;
+    double c = 0.0;								// Running compensation for lost low-order bits
+};
+
+// Count, sum, mean and variance of a set that values enter and leave one at a time (Welford's update and its inverse)
+class runningMoments {
+public:
+    void add(const double &x) {
+        ++n;
+        double d = x - m;
+        m += d / n;
+        m2 += d * (x - m);
+        total.add(x);
+    }
+    void remove(const double &x) {
+        if (n <= 1) {
+            clear();
+            return;
+        }
+        double d = x - m;
+        --n;
+        m -= d / n;
+        m2 -= d * (x - m);
+        if (m2 < 0)								// Rounding can leave a tiny negative remainder
+            m2 = 0;
+        total.remove(x);
+    }
+    void add(const runningMoments &other) {		// Combine two sets (Chan et al.)
+        if (other.n == 0)
+            return;
+        long nTotal = n + other.n;
+        double d = other.m - m;
+        m += d * other.n / nTotal;
+        m2 += other.m2 + d * d * n * other.n / nTotal;
+        n = nTotal;
+        total.add(other.total);
+    }
+    void clear() { n = 0; m = m2 = 0.0; total.clear(); }
+
+    long count() const { return n; }
+    double sum() const { return total.value(); }
+    double mean() const { return m; }
+    double variance() const { return n > 1 ? m2 / (n - 1) : 0.0; }
+
+private:
+    long n = 0;
+    double m = 0.0;								// Running mean
+    double m2 = 0.0;							// Sum of squared deviations from the mean
+    kahanSum total;
+};
+
+// Count, sum, mean and variance of values that are all replaced every timestep, gathered in one pass. Sums are
+// taken around a shift (the previous timestep's mean), which keeps the variance accurate without a division per value.
+class passMoments {
+public:
+    void begin() {
+        if (n > 0)
+            shift = mean();
+        n = 0;
+        s1.clear();
+        s2.clear();
+    }
+    void reset(const double &newShift) {		// Forget everything; the next pass sums around newShift
+        shift = newShift;
+        n = 0;
+        s1.clear();
+        s2.clear();
+    }
+    void add(const double &x) {
+        ++n;
+        double d = x - shift;
+        s1.add(d);
+        s2.add(d * d);
+    }
+    void add(const passMoments &other) {		// Combine two sets, re-expressing 'other' around this shift
+        if (other.n == 0)
+            return;
+        if (n == 0) {
+            *this = other;
+            return;
+        }
+        double k = other.shift - shift;
+        s2.add(other.s2);
+        s2.add(2 * k * other.s1.value());
+        s2.add(other.n * k * k);
+        s1.add(other.s1);
+        s1.add(other.n * k);
+        n += other.n;
+    }
+
+    long count() const { return n; }
+    double sum() const { return n * shift + s1.value(); }
+    double mean() const { return n > 0 ? shift + s1.value() / n : shift; }
+    double variance() const { return n > 1 ? std::fmax(0.0, (s2.value() - s1.value() * s1.value() / n) / (n - 1)) : 0.0; }
+
+private:
+    long n = 0;
+    double shift = 0.0;
+    kahanSum s1;								// Sums of (x - shift) and (x - shift)^2
+    kahanSum s2;
+};
+
+// Fixed-width bins over [lo, hi); values outside fall into the first or last bin. 0 bins = disabled, all calls are no-ops.
+class histogram {
+public:
+    histogram(const size_t &bins = 0, const double &lo = 0.0, const double &hi = 1.0)
+        : counts(bins, 0), lo(lo), scale(bins > 0 && hi > lo ? bins / (hi - lo) : 0.0) {}
+
+    void add(const double &x) { if (!counts.empty()) ++counts[bin(x)]; }
+    void remove(const double &x) { if (!counts.empty()) --counts[bin(x)]; }
+    void add(const histogram &other) {			// Same bins assumed
+        for (size_t b = 0; b < counts.size() && b < other.counts.size(); ++b)
+            counts[b] += other.counts[b];
+    }
+    void clear() { std::fill(counts.begin(), counts.end(), 0); }
+    size_t size() const { return counts.size(); }
+    long operator[](const size_t &b) const { return counts[b]; }
+
+private:
+    size_t bin(const double &x) const {
+        double b = (x - lo) * scale;
+        if (!(b > 0))								// Also NaN, which would fail both tests below
+            return 0;
+        return b >= counts.size() - 1 ? counts.size() - 1 : static_cast<size_t>(b);
+    }
+
+    std::vector<long> counts;
+    double lo;
+    double scale;								// Bins per unit
+};
+
+// Aggregates of a herd, kept up to date by the herd kernels instead of rescanning the herd:
+// - genes and ages of the living change only when individuals die or are born, so they are updated per event;
+// - damage changes for everyone every timestep, so it is gathered in the kill pass that visits every slot anyway.
+// 'Dead' totals cover the individuals that died in the last kill pass.
+class herdStats {
+public:
+    herdStats(const parameters &p = parameters());
+
+    template<typename Storage>
+    void rebuild(const basicHerd<Storage> &h);	// Recount the living from scratch: at the start, after a resume, and now and then to drop rounding drift
+    template<typename Storage>
+    void rebuild(const basicHerd<Storage> &h, const size_t &begin, const size_t &end);	// Same, for slots [begin, end) only
+    void clear();								// No individuals at all
+    void add(const herdStats &other);			// Combine with the statistics of other slots; same parameters assumed
+
+    bool gatherDamage = true;					// Whether the next kill pass collects the survivors' damage; skip it when not reported
+
+    //Hooks for the herd kernels
+    void beginTimestep();						// Called by herd::kill before its pass
+    void survivor(const double &d1, const double &d2) {
+        damageAlive[0].add(d1);
+        damageAlive[1].add(d2);
+        damageHist[0].add(d1);
+        damageHist[1].add(d2);
+    }
+    void death(const double &g1, const double &g2, const double &g3, const int &age, const double &d1, const double &d2) {
+        const double g[3] = { g1, g2, g3 };
+        for (int k = 0; k < 3; ++k) {
+            genAlive[k].remove(g[k]);
+            genHist[k].remove(g[k]);
+            genDead[k].add(g[k]);
+        }
+        ageAlive -= age;
+        ageDead += age;
+        damageDead[0].add(d1);
+        damageDead[1].add(d2);
+        ++nDead;
+    }
+    void birth(const double &g1, const double &g2, const double &g3) {	// Newborns are age 0; their damage is counted in the next kill pass
+        const double g[3] = { g1, g2, g3 };
+        for (int k = 0; k < 3; ++k) {
+            genAlive[k].add(g[k]);
+            genHist[k].add(g[k]);
+        }
+    }
+    void advanceAge() { ageAlive += genAlive[0].count(); }	// Called by herd::advanceAge
+
+    //Living
+    long nAlive() const { return genAlive[0].count(); }
+    long long ageAlive = 0;						// Summed age; exact in integers
+    runningMoments genAlive[3];
+    passMoments damageAlive[2];					// As of the last kill pass that gathered damage
+    histogram genHist[3];
+    histogram damageHist[2];					// Also as of the last kill pass that gathered damage
+
+    //Died in the last kill pass
+    long nDead = 0;
+    long long ageDead = 0;
+    kahanSum genDead[3];
+    kahanSum damageDead[2];
+};
+
+#endif //MILS_HERDSTATS_H
@@ -0,0 +1,131 @@
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <algorithm>
+#include <stdexcept>
+#include "instrumentation.h"
+
+namespace {
+    struct finishedRun {
+        std::string name;
+        std::vector<instrumentation::window> windows;
+        std::vector<instrumentation::traceEvent> events;
+    };
+
+    std::mutex finishedMutex;
+    std::vector<finishedRun> finished;					// Guarded by finishedMutex
+
+    const instrumentation::clock::time_point epoch = instrumentation::clock::now();
+
+    thread_local instrumentation ownRecord;
+    thread_local instrumentation *currentRecord = nullptr;
+
+    int64_t sinceEpoch(const instrumentation::clock::time_point &t) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t - epoch).count();
+    }
+}
+
+const char* timerName(const timer &t) {
+    const char *names[nTimers] = { "addDamage", "kill", "parentSampling", "mutation", "migration", "statistics", "output", "checkpoint" };
+    return names[static_cast<int>(t)];
+}
+
+const char* counterName(const counter &c) {
+    const char *names[nCounters] = { "rngDraws", "deathsExtrinsic", "deathsDamage1", "deathsDamage2", "births", "bytesWritten" };
+    return names[static_cast<int>(c)];
+}
+
+instrumentation& instrumentation::local() {
+    return currentRecord ? *currentRecord : ownRecord;
+}
+
+void instrumentation::reportTo(instrumentation *record) {
+    currentRecord = record;
+}
+
+void instrumentation::beginRun(const std::string &runName, const bool &traceRun) {
+    name = runName;
+    trace = traceRun;
+    std::fill(seconds, seconds + nTimers, 0.0);
+    for (std::atomic<uint64_t> &c : counts)
+        c.store(0, std::memory_order_relaxed);
+    windows.clear();
+    events.clear();
+}
+
+void instrumentation::addTime(const timer &t, const clock::time_point &start, const clock::time_point &stop) {
+    seconds[static_cast<int>(t)] += std::chrono::duration<double>(stop - start).count();
+    if (trace)
+        events.push_back({ t, sinceEpoch(start), sinceEpoch(stop) - sinceEpoch(start) });
+}
+
+void instrumentation::closeWindow(const int &firstGeneration, const int &lastGeneration) {
+    window w;
+    w.firstGeneration = firstGeneration;
+    w.lastGeneration = lastGeneration;
+    for (int t = 0; t < nTimers; ++t) {
+        w.seconds[t] = seconds[t];
+        seconds[t] = 0.0;
+    }
+    for (int c = 0; c < nCounters; ++c)
+        w.counts[c] = counts[c].exchange(0, std::memory_order_relaxed);
+    windows.push_back(w);
+}
+
+void instrumentation::endRun() {
+    if (!windows.empty()) {								// Counts after the last window (final flushes of the output) go into it
+        for (int c = 0; c < nCounters; ++c)
+            windows.back().counts[c] += counts[c].exchange(0, std::memory_order_relaxed);
+    }
+    std::lock_guard<std::mutex> lock(finishedMutex);
+    finished.push_back({ name, std::move(windows), std::move(events) });
+    windows.clear();
+    events.clear();
+}
+
+void writeInstrumentation(std::ostream &os) {
+    std::lock_guard<std::mutex> lock(finishedMutex);
+    std::vector<const finishedRun*> runs;
+    for (const finishedRun &r : finished)
+        runs.push_back(&r);
+    std::sort(runs.begin(), runs.end(), [](const finishedRun *a, const finishedRun *b) { return a->name < b->name; });
+
+    for (const finishedRun *r : runs) {
+        os << "\n# Timing breakdown of " << r->name << " (seconds and counts per window of generations)\n# Generations";
+        for (int t = 0; t < nTimers; ++t)
+            os << "\t" << timerName(static_cast<timer>(t));
+        for (int c = 0; c < nCounters; ++c)
+            os << "\t" << counterName(static_cast<counter>(c));
+        os << "\n";
+        for (const instrumentation::window &w : r->windows) {
+            os << "# " << w.firstGeneration << "-" << w.lastGeneration;
+            for (int t = 0; t < nTimers; ++t)
+                os << "\t" << w.seconds[t];
+            for (int c = 0; c < nCounters; ++c)
+                os << "\t" << w.counts[c];
+            os << "\n";
+        }
+    }
+}
+
+void writeTrace(const std::string &fileName) {
+    std::ofstream ofs(fileName);
+    if (!ofs.is_open())
+        throw std::runtime_error("Cannot open trace file: " + fileName);
+
+    std::lock_guard<std::mutex> lock(finishedMutex);
+    ofs << std::fixed << std::setprecision(3);					// Microseconds, to the nanosecond
+    ofs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (size_t r = 0; r < finished.size(); ++r) {			// One trace 'thread' per run, so replicates line up in the viewer
+        if (finished[r].events.empty())
+            continue;
+        ofs << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << r
+            << ",\"args\":{\"name\":\"" << finished[r].name << "\"}}";
+        first = false;
+        for (const instrumentation::traceEvent &e : finished[r].events)
+            ofs << ",\n{\"name\":\"" << timerName(e.t) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << r
+                << ",\"ts\":" << e.start / 1000.0 << ",\"dur\":" << e.duration / 1000.0 << "}";
+    }
+    ofs << "\n]}\n";
+}
@@ -0,0 +1,98 @@
+#ifndef MILS_INSTRUMENTATION_H
+#define MILS_INSTRUMENTATION_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+// Opt-in timers and counters for finding out where a run spends its time. Compile with -DMILS_INSTRUMENT to enable;
+// without it MILS_TIME and MILS_COUNT expand to nothing and simulate() skips all bookkeeping.
+//
+// Every replicate thread has its own record. simulate() closes a window every 'instrumentWindow' generations; main()
+// appends the windows of all replicates to logfile.txt and, when 'traceFile' is set, writes every timed scope as a
+// Chrome trace-event file (open in chrome://tracing or https://ui.perfetto.dev).
+
+enum class timer { addDamage, kill, parentSampling, mutation, migration, statistics, output, checkpoint, count };
+enum class counter { rngDraws, deathsExtrinsic, deathsDamage1, deathsDamage2, births, bytesWritten, count };
+
+const int nTimers = static_cast<int>(timer::count);
+const int nCounters = static_cast<int>(counter::count);
+
+const char* timerName(const timer &t);
+const char* counterName(const counter &c);
+
+// Whether the instrumentation is compiled in
+constexpr bool instrumentationEnabled() {
+#ifdef MILS_INSTRUMENT
+    return true;
+#else
+    return false;
+#endif
+}
+
+//Class def:
+// Timings and counts of one run, collected per window of generations
+class instrumentation {
+public:
+    using clock = std::chrono::steady_clock;
+
+    struct window {
+        int firstGeneration, lastGeneration;
+        double seconds[nTimers];
+        uint64_t counts[nCounters];
+    };
+    struct traceEvent {
+        timer t;
+        int64_t start, duration;				// Nanoseconds since the start of the program
+    };
+
+    static instrumentation& local();			// Record of the calling thread, or the one it reports to
+    static void reportTo(instrumentation *record);	// Count into 'record' from the calling thread (nullptr = its own record)
+
+    void beginRun(const std::string &name, const bool &trace);	// Start recording a run; clears the previous one
+    void addTime(const timer &t, const clock::time_point &start, const clock::time_point &stop);
+    void count(const counter &c, const uint64_t &n) { counts[static_cast<int>(c)].fetch_add(n, std::memory_order_relaxed); }	// Safe from other threads
+    void closeWindow(const int &firstGeneration, const int &lastGeneration);	// Store the totals since the last window
+    void endRun();								// Hand the run over to writeInstrumentation / writeTrace. Output is counted
+                                                // in bytes when it reaches the file, so it arrives in bursts, the last at the end
+
+private:
+    std::string name;
+    bool trace = false;
+    double seconds[nTimers] = {};
+    std::atomic<uint64_t> counts[nCounters] = {};	// Atomic: async output threads count bytes into their owner's record
+    std::vector<window> windows;
+    std::vector<traceEvent> events;
+};
+
+// Times the enclosing scope
+class scopedTimer {
+public:
+    scopedTimer(const timer &t) : t(t), start(instrumentation::clock::now()) {}
+    ~scopedTimer() { instrumentation::local().addTime(t, start, instrumentation::clock::now()); }
+
+private:
+    timer t;
+    instrumentation::clock::time_point start;
+};
+
+// Append the windows of all finished runs to a run log, as '#' comment lines so it still loads as a config file
+void writeInstrumentation(std::ostream &os);
+
+// Write the timed scopes of all finished runs that asked for a trace as Chrome trace-event JSON
+void writeTrace(const std::string &fileName);
+
+#define MILS_CONCAT_(a, b) a##b
+#define MILS_CONCAT(a, b) MILS_CONCAT_(a, b)
+#ifdef MILS_INSTRUMENT
+#define MILS_TIME(t) scopedTimer MILS_CONCAT(milsTimer, __LINE__)(t)
+#define MILS_COUNT(c, n) instrumentation::local().count(c, n)
+#else
+#define MILS_TIME(t) do {} while (0)
+#define MILS_COUNT(c, n) do {} while (0)
+#endif
+
+#endif //MILS_INSTRUMENTATION_H
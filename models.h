@@ -0,0 +1,69 @@
+#ifndef MILS_MODELS_H
+#define MILS_MODELS_H
+
+#include <cmath>
+#include "parameters.h"
+
+// Policy types for the laws that can be swapped by a config key (mortalityModel, damageModel). The kernels that use
+// them are templates on the policy, so the inner loops call a small inline function instead of branching on the law;
+// withMortality / withDamage / withModels pick the instantiation once per call, outside the loop. Adding a law means
+// a policy type here, a value in the enum and lawName (parameters.h/.cpp), and a case in the dispatch below.
+
+//Mortality: chance to die in this timestep from the damage d of one trait (1 or 2)
+struct gompertzMortality {
+    gompertzMortality(const parameters &p, const int &trait) : rho(trait == 1 ? p.rho1 : p.rho2), beta(trait == 1 ? p.beta1 : p.beta2) {}
+    double operator()(const double &d) const { return std::exp(-rho * std::exp(-beta * d)); }
+    double rho, beta;
+};
+
+struct linearMortality {
+    linearMortality(const parameters &p, const int &) : phi(p.phi) {}
+    double operator()(const double &d) const { return std::fmin(phi * d, 1.0); }
+    double phi;
+};
+
+struct weibullMortality {
+    weibullMortality(const parameters &p, const int &) : scale(p.weibullScale), shape(p.weibullShape) {}
+    double operator()(const double &d) const { return 1 - std::exp(-std::pow(d / scale, shape)); }
+    double scale, shape;
+};
+
+//Damage allocation: fraction of new damage that goes to trait 1, given the genes and (d1 - d2) / (d1 + d2)
+struct logisticDamage {
+    logisticDamage(const parameters &) {}
+    double operator()(const double &g2, const double &g3, const double &relativeDamage) const { return 1 / (1 + std::exp(-g2 * relativeDamage + g3)); }
+};
+
+struct evenDamage {
+    evenDamage(const parameters &) {}
+    double operator()(const double &, const double &, const double &) const { return 0.5; }
+};
+
+// Call f(mortality of trait 1, mortality of trait 2) with the policies selected by p.mortalityModel
+template<typename F>
+decltype(auto) withMortality(const parameters &p, F &&f) {
+    switch (p.mortalityModel) {
+    case mortalityLaw::linear:  return f(linearMortality(p, 1), linearMortality(p, 2));
+    case mortalityLaw::weibull: return f(weibullMortality(p, 1), weibullMortality(p, 2));
+    default:                    return f(gompertzMortality(p, 1), gompertzMortality(p, 2));
+    }
+}
+
+// Call f(damage allocation) with the policy selected by p.damageModel
+template<typename F>
+decltype(auto) withDamage(const parameters &p, F &&f) {
+    switch (p.damageModel) {
+    case damageLaw::even: return f(evenDamage(p));
+    default:              return f(logisticDamage(p));
+    }
+}
+
+// Call f(mortality 1, mortality 2, damage allocation): every combination of laws is instantiated
+template<typename F>
+decltype(auto) withModels(const parameters &p, F &&f) {
+    return withMortality(p, [&](const auto &m1, const auto &m2) {
+        return withDamage(p, [&](const auto &damage) { return f(m1, m2, damage); });
+    });
+}
+
+#endif //MILS_MODELS_H
@@ -0,0 +1,264 @@
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include "output.h"
+#include "asyncsink.h"
+#include "instrumentation.h"
+
+namespace {
+    bool littleEndianHost() {
+        const uint16_t one = 1;
+        unsigned char first;
+        std::memcpy(&first, &one, 1);
+        return first == 1;
+    }
+
+    template<typename T>
+    void encodeLE(char *bytes, const T &x) {
+        std::memcpy(bytes, &x, sizeof(T));
+        if (!littleEndianHost())
+            for (size_t i = 0; i < sizeof(T) / 2; ++i)
+                std::swap(bytes[i], bytes[sizeof(T) - 1 - i]);
+    }
+
+    template<typename T>
+    void putLE(std::vector<char> &out, const T &x) {		// Append x to out in little-endian byte order
+        char bytes[sizeof(T)];
+        encodeLE(bytes, x);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    template<typename T>
+    T getLE(std::istream &is) {
+        char bytes[sizeof(T)];
+        if (!is.read(bytes, sizeof(T)))
+            throw std::runtime_error("Unexpected end of columnar file");
+        if (!littleEndianHost())
+            for (size_t i = 0; i < sizeof(T) / 2; ++i)
+                std::swap(bytes[i], bytes[sizeof(T) - 1 - i]);
+        T x;
+        std::memcpy(&x, bytes, sizeof(T));
+        return x;
+    }
+
+    template<typename T>
+    T decodeLE(const char *bytes) {
+        char tmp[sizeof(T)];
+        std::memcpy(tmp, bytes, sizeof(T));
+        if (!littleEndianHost())
+            for (size_t i = 0; i < sizeof(T) / 2; ++i)
+                std::swap(tmp[i], tmp[sizeof(T) - 1 - i]);
+        T x;
+        std::memcpy(&x, tmp, sizeof(T));
+        return x;
+    }
+
+    const char magic[8] = { 'M', 'I', 'L', 'S', 'C', 'O', 'L', '1' };
+
+    std::ios::openmode prepareFile(const std::string &fileName, const int64_t &resumeAt) {	// Cut a file back for resuming; mode to open it with
+        if (resumeAt < 0)
+            return std::ios::out | std::ios::trunc;
+        if (!std::filesystem::exists(fileName) || std::filesystem::file_size(fileName) < static_cast<uint64_t>(resumeAt))
+            throw std::runtime_error("Cannot resume " + fileName + ": file is missing or shorter than at the checkpoint");
+        std::filesystem::resize_file(fileName, resumeAt);
+        return std::ios::out | std::ios::app;
+    }
+    const size_t csvBufferSize = 1 << 20;
+    const size_t csvRowSlack = 1 << 16;					// Room for the row that crosses csvBufferSize, so the buffer never grows
+}
+
+void tableSink::addRow(std::initializer_list<double> values) {
+    if (values.size() != columns.size())
+        throw std::invalid_argument("Row has " + std::to_string(values.size()) + " values, table has " + std::to_string(columns.size()) + " columns");
+    addRow(values.begin());
+}
+
+csvSink::csvSink(const std::string &fileName, const std::vector<column> &columns, const std::string &separator, const int64_t &resumeAt)
+    : tableSink(columns), fileName(fileName), separator(separator) {
+    buffer.reserve(csvBufferSize + csvRowSlack);
+    ofs.open(fileName, prepareFile(fileName, resumeAt));
+    if (!ofs.is_open())
+        throw std::runtime_error("Cannot open output file: " + fileName);
+    if (resumeAt >= 0) {
+        written = resumeAt;
+        return;
+    }
+    for (size_t c = 0; c < columns.size(); ++c)
+        buffer += (c ? separator : "") + columns[c].name;
+    buffer += '\n';
+}
+
+csvSink::~csvSink() {
+    try {
+        if (ofs.is_open())
+            close();
+    }
+    catch (...) {}											// Owners that need to know close() themselves
+}
+
+void csvSink::addRow(const double *values) {
+    char field[32];
+    for (size_t c = 0; c < columns.size(); ++c) {
+        if (c)
+            buffer += separator;
+        if (columns[c].type == columnType::int32)
+            std::snprintf(field, sizeof(field), "%lld", static_cast<long long>(values[c]));
+        else
+            std::snprintf(field, sizeof(field), "%g", values[c]);	// Same as the default std::ostream formatting
+        buffer += field;
+    }
+    buffer += '\n';
+    if (buffer.size() >= csvBufferSize)
+        flush();
+}
+
+void csvSink::flush() {
+    ofs.write(buffer.data(), buffer.size());
+    ofs.flush();
+    if (!ofs)
+        throw std::runtime_error("Error writing " + fileName);
+    written += buffer.size();
+    MILS_COUNT(counter::bytesWritten, buffer.size());
+    buffer.clear();
+}
+
+void csvSink::close() {
+    flush();
+    ofs.close();
+    if (!ofs)
+        throw std::runtime_error("Error writing " + fileName);
+}
+
+binarySink::binarySink(const std::string &fileName, const std::vector<column> &columns, const size_t &chunkRows, const int64_t &resumeAt)
+    : tableSink(columns), fileName(fileName), chunkRows(chunkRows), data(columns.size()) {
+    for (size_t c = 0; c < columns.size(); ++c)		// Whole chunk up front, so adding rows never reallocates
+        data[c].reserve(chunkRows * (columns[c].type == columnType::int32 ? 4 : 8));
+    ofs.open(fileName, prepareFile(fileName, resumeAt) | std::ios::binary);
+    if (!ofs.is_open())
+        throw std::runtime_error("Cannot open output file: " + fileName);
+    if (resumeAt >= 0) {
+        written = resumeAt;
+        return;
+    }
+
+    std::vector<char> header(magic, magic + sizeof(magic));
+    putLE<uint32_t>(header, static_cast<uint32_t>(columns.size()));
+    for (const column &c : columns) {
+        putLE<uint8_t>(header, static_cast<uint8_t>(c.type));
+        putLE<uint16_t>(header, static_cast<uint16_t>(c.name.size()));
+        header.insert(header.end(), c.name.begin(), c.name.end());
+    }
+    ofs.write(header.data(), header.size());
+    if (!ofs)
+        throw std::runtime_error("Error writing " + fileName);
+    written += header.size();
+}
+
+binarySink::~binarySink() {
+    try {
+        if (ofs.is_open())
+            close();
+    }
+    catch (...) {}											// Owners that need to know close() themselves
+}
+
+void binarySink::addRow(const double *values) {
+    for (size_t c = 0; c < columns.size(); ++c) {
+        if (columns[c].type == columnType::int32)
+            putLE<int32_t>(data[c], static_cast<int32_t>(values[c]));
+        else
+            putLE<double>(data[c], values[c]);
+    }
+    if (++nRows == chunkRows)
+        flush();
+}
+
+void binarySink::flush() {
+    if (nRows == 0)
+        return;
+    char count[sizeof(uint32_t)];
+    encodeLE<uint32_t>(count, static_cast<uint32_t>(nRows));
+    ofs.write(count, sizeof(count));
+    uint64_t bytes = sizeof(count);
+    for (const std::vector<char> &d : data) {
+        ofs.write(d.data(), d.size());
+        bytes += d.size();
+    }
+    ofs.flush();
+    if (!ofs)
+        throw std::runtime_error("Error writing " + fileName);
+    written += bytes;
+    MILS_COUNT(counter::bytesWritten, bytes);
+    for (std::vector<char> &d : data)
+        d.clear();
+    nRows = 0;
+}
+
+void binarySink::close() {
+    flush();
+    char end[sizeof(uint32_t)];
+    encodeLE<uint32_t>(end, 0);
+    ofs.write(end, sizeof(end));
+    ofs.close();
+    if (!ofs)
+        throw std::runtime_error("Error writing " + fileName);
+}
+
+columnarReader::columnarReader(const std::string &fileName) : ifs(fileName, std::ios::binary) {
+    if (!ifs.is_open())
+        throw std::runtime_error("Cannot open columnar file: " + fileName);
+    char m[sizeof(magic)];
+    if (!ifs.read(m, sizeof(m)) || std::memcmp(m, magic, sizeof(magic)) != 0)
+        throw std::runtime_error(fileName + " is not a columnar output file");
+
+    uint32_t nColumns = getLE<uint32_t>(ifs);
+    for (uint32_t c = 0; c < nColumns; ++c) {
+        column col;
+        uint8_t type = getLE<uint8_t>(ifs);
+        if (type > static_cast<uint8_t>(columnType::float64))
+            throw std::runtime_error("Unknown column type in " + fileName);
+        col.type = static_cast<columnType>(type);
+        col.name.resize(getLE<uint16_t>(ifs));
+        ifs.read(&col.name[0], col.name.size());
+        columns.push_back(col);
+    }
+    chunk.resize(columns.size());
+}
+
+bool columnarReader::nextChunk() {
+    if (finished || ifs.peek() == std::char_traits<char>::eof())
+        return false;
+    nRows = getLE<uint32_t>(ifs);
+    if (nRows == 0) {
+        finished = true;
+        return false;
+    }
+    std::vector<char> raw;
+    for (size_t c = 0; c < columns.size(); ++c) {
+        const size_t width = columns[c].type == columnType::int32 ? 4 : 8;
+        raw.resize(nRows * width);
+        if (!ifs.read(raw.data(), raw.size()))
+            throw std::runtime_error("Truncated chunk in columnar file");
+        chunk[c].resize(nRows);
+        for (size_t i = 0; i < nRows; ++i)
+            chunk[c][i] = width == 4 ? decodeLE<int32_t>(&raw[i * 4]) : decodeLE<double>(&raw[i * 8]);
+    }
+    return true;
+}
+
+std::unique_ptr<tableSink> openTable(const parameters &p, const std::string &baseName, const std::vector<column> &columns,
+                                     const std::string &csvSeparator, const int64_t &resumeAt) {
+    std::unique_ptr<tableSink> sink;
+    if (p.outputFormat == "csv")
+        sink = std::make_unique<csvSink>(baseName + ".csv", columns, csvSeparator, resumeAt);
+    else if (p.outputFormat == "binary")
+        sink = std::make_unique<binarySink>(baseName + ".mcol", columns, 65536, resumeAt);
+    else
+        throw std::invalid_argument("Unknown outputFormat: " + p.outputFormat + " (csv or binary)");
+
+    if (p.asyncOutput)
+        sink = std::make_unique<asyncSink>(std::move(sink), std::max(1, p.outputQueueBlocks));
+    return sink;
+}
@@ -0,0 +1,104 @@
+#ifndef MILS_OUTPUT_H
+#define MILS_OUTPUT_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <cstdint>
+#include <initializer_list>
+#include "parameters.h"
+
+// Column of an output table. Values are passed around as doubles; int32 columns are stored as integers.
+enum class columnType : uint8_t { int32 = 0, float64 = 1 };
+
+struct column {
+    std::string name;
+    columnType type;
+};
+
+//Class def:
+// Destination for one output table (the MGD_, Individual_Data, cohort and sweep files). Rows are buffered;
+// everything is written out by flush(), close() or on destruction. flush() and close() throw when a write fails;
+// the destructor can't, so owners close() their tables to learn of errors.
+class tableSink {
+public:
+    explicit tableSink(const std::vector<column> &columns) : columns(columns) {}
+    virtual ~tableSink() = default;
+
+    void addRow(std::initializer_list<double> values);		// Checks the number of values against the columns
+    virtual void addRow(const double *values) = 0;			// One value per column
+    virtual void flush() = 0;
+    virtual void close() { flush(); }						// Write out everything and finish the file
+    virtual uint64_t bytesWritten() const = 0;				// Size of the file after the last flush()
+    const std::vector<column> &getColumns() const { return columns; }
+
+protected:
+    std::vector<column> columns;
+};
+
+// Text output, as the simulation always wrote it: a header line, then one line per row.
+// With resumeAt >= 0 an existing file is cut back to resumeAt bytes and appended to (see checkpoint.h).
+class csvSink : public tableSink {
+public:
+    csvSink(const std::string &fileName, const std::vector<column> &columns, const std::string &separator = ",", const int64_t &resumeAt = -1);
+    ~csvSink() override;
+    void addRow(const double *values) override;
+    void flush() override;
+    void close() override;
+    uint64_t bytesWritten() const override { return written; }
+
+private:
+    std::ofstream ofs;
+    std::string fileName;
+    std::string separator;
+    std::string buffer;										// Formatted rows not yet written
+    uint64_t written = 0;
+};
+
+// Binary columnar output. Layout, all integers little-endian:
+//   "MILSCOL1", uint32 nColumns, per column { uint8 type, uint16 nameLength, name }
+//   chunks of { uint32 nRows, then per column nRows values (int32 or float64) }
+//   a final chunk with nRows = 0 marks a completely written file
+class binarySink : public tableSink {
+public:
+    binarySink(const std::string &fileName, const std::vector<column> &columns, const size_t &chunkRows = 65536, const int64_t &resumeAt = -1);
+    ~binarySink() override;
+    void addRow(const double *values) override;
+    void flush() override;									// Writes the buffered rows as one chunk
+    void close() override;									// Also writes the end-of-file marker
+    uint64_t bytesWritten() const override { return written; }
+
+private:
+    std::ofstream ofs;
+    std::string fileName;
+    uint64_t written = 0;
+    size_t chunkRows;
+    size_t nRows = 0;										// Rows in the current chunk
+    std::vector<std::vector<char>> data;					// Per column: encoded values of the current chunk
+};
+
+// Reads files written by binarySink, one chunk at a time
+class columnarReader {
+public:
+    explicit columnarReader(const std::string &fileName);
+    const std::vector<column> &getColumns() const { return columns; }
+    bool nextChunk();										// Load the next chunk; false at the end of the file
+    size_t rows() const { return nRows; }
+    const std::vector<double> &values(const size_t &col) const { return chunk[col]; }	// Column of the current chunk
+    bool complete() const { return finished; }				// The end-of-file marker was read
+
+private:
+    std::ifstream ifs;
+    std::vector<column> columns;
+    size_t nRows = 0;
+    bool finished = false;
+    std::vector<std::vector<double>> chunk;
+};
+
+// Open 'baseName' + ".csv" or + ".mcol", depending on p.outputFormat ("csv" or "binary"); wrapped in an asyncSink if p.asyncOutput.
+// resumeAt >= 0 continues an existing file from that byte offset instead of starting a new one.
+std::unique_ptr<tableSink> openTable(const parameters &p, const std::string &baseName, const std::vector<column> &columns,
+                                     const std::string &csvSeparator = ",", const int64_t &resumeAt = -1);
+
+#endif //MILS_OUTPUT_H
@@ -0,0 +1,307 @@
+#include <cstring>
+#include <cmath>
+#include <charconv>
+#include <fstream>
+#include <stdexcept>
+#include "outputreader.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MILS_HAVE_MMAP
+#endif
+
+namespace {
+    const size_t csvBlockRows = 8192;			// Rows per block of a CSV table; .mcol tables come in their own chunks
+
+    bool littleEndianHost() {
+        const uint16_t one = 1;
+        unsigned char first;
+        std::memcpy(&first, &one, 1);
+        return first == 1;
+    }
+
+    template<typename T>
+    T decodeLE(const char *bytes) {
+        char tmp[sizeof(T)];
+        std::memcpy(tmp, bytes, sizeof(T));
+        if (!littleEndianHost())
+            for (size_t i = 0; i < sizeof(T) / 2; ++i)
+                std::swap(tmp[i], tmp[sizeof(T) - 1 - i]);
+        T x;
+        std::memcpy(&x, tmp, sizeof(T));
+        return x;
+    }
+
+    std::string trim(const std::string &s) {
+        size_t first = s.find_first_not_of(" \t\r");
+        if (first == std::string::npos)
+            return "";
+        size_t last = s.find_last_not_of(" \t\r");
+        return s.substr(first, last - first + 1);
+    }
+
+    double parseValue(const std::string &text, const std::string &expression) {
+        const std::string t = trim(text);
+        double x;
+        std::from_chars_result r = std::from_chars(t.data(), t.data() + t.size(), x);
+        if (t.empty() || r.ec != std::errc() || r.ptr != t.data() + t.size())
+            throw std::invalid_argument("Bad number in filter: " + expression);
+        return x;
+    }
+
+    //Class def:
+    // Text tables as written by csvSink: a header line, then one line of numbers per row, separated by ',' or ', '
+    class csvReader : public tableReader {
+    public:
+        explicit csvReader(const std::string &fileName) : fileName(fileName), file(fileName) {
+            const char *begin = file.data(), *end = begin + file.size();
+            const char *eol = static_cast<const char*>(std::memchr(begin, '\n', file.size()));
+            if (!eol)
+                throw std::runtime_error(fileName + " has no header line");
+            std::string header(begin, eol);
+            for (size_t start = 0; start <= header.size(); ) {
+                size_t comma = header.find(',', start);
+                if (comma == std::string::npos)
+                    comma = header.size();
+                columns.push_back({ trim(header.substr(start, comma - start)), columnType::float64 });
+                start = comma + 1;
+            }
+            block.resize(columns.size());
+            for (std::vector<double> &b : block)
+                b.reserve(csvBlockRows);
+            pos = eol + 1;
+            last = end;
+            lineNr = 1;
+        }
+
+        bool nextBlock() override {
+            for (std::vector<double> &b : block)
+                b.clear();
+            nRows = 0;
+            while (nRows < csvBlockRows && pos < last) {
+                const char *eol = static_cast<const char*>(std::memchr(pos, '\n', last - pos));
+                if (!eol)								// Cut off by a writer that has not finished the line
+                    break;
+                ++lineNr;
+                const char *p = pos;
+                pos = eol + 1;
+                while (p < eol && (*p == ' ' || *p == '\r'))
+                    ++p;
+                if (p == eol)							// Empty line
+                    continue;
+                for (size_t c = 0; c < columns.size(); ++c) {
+                    while (p < eol && *p == ' ')
+                        ++p;
+                    double x;
+                    std::from_chars_result r = std::from_chars(p, eol, x);
+                    if (r.ec != std::errc())
+                        throw std::runtime_error("Bad number in " + fileName + ", line " + std::to_string(lineNr));
+                    block[c].push_back(x);
+                    p = r.ptr;
+                    while (p < eol && (*p == ' ' || *p == '\r'))
+                        ++p;
+                    if (c + 1 < columns.size()) {
+                        if (p == eol || *p != ',')
+                            throw std::runtime_error("Too few values in " + fileName + ", line " + std::to_string(lineNr));
+                        ++p;
+                    }
+                }
+                ++nRows;
+            }
+            return nRows > 0;
+        }
+
+        bool complete() const override { return file.size() == 0 || file.data()[file.size() - 1] == '\n'; }
+
+    private:
+        std::string fileName;
+        mappedFile file;
+        const char *pos = nullptr;						// Start of the next line
+        const char *last = nullptr;
+        long lineNr = 0;
+    };
+
+    //Class def:
+    // Binary tables as written by binarySink (layout in output.h); each chunk is one block
+    class mcolReader : public tableReader {
+    public:
+        explicit mcolReader(const std::string &fileName) : fileName(fileName), file(fileName) {
+            pos = 8;									// Magic, checked by openTableReader
+            const uint32_t nColumns = get<uint32_t>();
+            for (uint32_t c = 0; c < nColumns; ++c) {
+                column col;
+                const uint8_t type = get<uint8_t>();
+                if (type > static_cast<uint8_t>(columnType::float64))
+                    throw std::runtime_error("Unknown column type in " + fileName);
+                col.type = static_cast<columnType>(type);
+                const uint16_t nameLength = get<uint16_t>();
+                need(nameLength);
+                col.name.assign(file.data() + pos, nameLength);
+                pos += nameLength;
+                columns.push_back(col);
+            }
+            block.resize(columns.size());
+        }
+
+        bool nextBlock() override {
+            nRows = 0;
+            if (finished || file.size() - pos < 4)
+                return false;
+            const size_t n = decodeLE<uint32_t>(file.data() + pos);
+            if (n == 0) {
+                finished = true;
+                return false;
+            }
+            size_t bytes = 0;
+            for (const column &col : columns)
+                bytes += n * (col.type == columnType::int32 ? 4 : 8);
+            if (file.size() - pos - 4 < bytes)			// Chunk cut off by a writer that has not finished it
+                return false;
+            pos += 4;
+            for (size_t c = 0; c < columns.size(); ++c) {
+                const char *raw = file.data() + pos;
+                block[c].resize(n);
+                if (columns[c].type == columnType::int32) {
+                    for (size_t i = 0; i < n; ++i)
+                        block[c][i] = decodeLE<int32_t>(raw + 4 * i);
+                    pos += 4 * n;
+                }
+                else {
+                    if (littleEndianHost())
+                        std::memcpy(block[c].data(), raw, 8 * n);
+                    else
+                        for (size_t i = 0; i < n; ++i)
+                            block[c][i] = decodeLE<double>(raw + 8 * i);
+                    pos += 8 * n;
+                }
+            }
+            nRows = n;
+            return true;
+        }
+
+        bool complete() const override { return finished; }
+
+    private:
+        void need(const size_t &bytes) const {
+            if (file.size() - pos < bytes)
+                throw std::runtime_error("Truncated header in " + fileName);
+        }
+
+        template<typename T>
+        T get() {
+            need(sizeof(T));
+            T x = decodeLE<T>(file.data() + pos);
+            pos += sizeof(T);
+            return x;
+        }
+
+        std::string fileName;
+        mappedFile file;
+        size_t pos = 0;
+        bool finished = false;
+    };
+}
+
+mappedFile::mappedFile(const std::string &fileName) {
+#ifdef MILS_HAVE_MMAP
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Cannot open " + fileName);
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot read " + fileName);
+    }
+    length = static_cast<size_t>(st.st_size);
+    if (length > 0) {
+        void *p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Cannot map " + fileName);
+        }
+        ::madvise(p, length, MADV_SEQUENTIAL);		// Read ahead, and let pages already read go first
+        ptr = static_cast<const char*>(p);
+    }
+    ::close(fd);								// The mapping stays valid
+#else
+    std::ifstream ifs(fileName, std::ios::binary);
+    if (!ifs.is_open())
+        throw std::runtime_error("Cannot open " + fileName);
+    copy.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    ptr = copy.data();
+    length = copy.size();
+#endif
+}
+
+mappedFile::~mappedFile() {
+#ifdef MILS_HAVE_MMAP
+    if (ptr)
+        ::munmap(const_cast<char*>(ptr), length);
+#endif
+}
+
+size_t tableReader::columnIndex(const std::string &name) const {
+    const std::string wanted = trim(name);
+    for (size_t c = 0; c < columns.size(); ++c)
+        if (columns[c].name == wanted)
+            return c;
+    throw std::invalid_argument("No column " + wanted);
+}
+
+std::unique_ptr<tableReader> openTableReader(const std::string &fileName) {
+    char m[8] = {};
+    {
+        std::ifstream ifs(fileName, std::ios::binary);
+        if (!ifs.is_open())
+            throw std::runtime_error("Cannot open " + fileName);
+        ifs.read(m, sizeof(m));
+    }
+    if (std::memcmp(m, "MILSCOL1", sizeof(m)) == 0)
+        return std::make_unique<mcolReader>(fileName);
+    return std::make_unique<csvReader>(fileName);
+}
+
+rowFilter::rowFilter(const tableReader &table, const std::string &expression) : table(table) {
+    const size_t opPos = expression.find_first_of("=!<>");
+    if (opPos == std::string::npos)
+        throw std::invalid_argument("No comparison in filter: " + expression);
+    std::string left = expression.substr(0, opPos);
+    const size_t percent = left.find('%');
+    if (percent != std::string::npos) {
+        modulus = parseValue(left.substr(percent + 1), expression);
+        if (modulus == 0)
+            throw std::invalid_argument("Modulus 0 in filter: " + expression);
+        left = left.substr(0, percent);
+    }
+    col = table.columnIndex(left);
+
+    const std::string rest = expression.substr(opPos);
+    size_t opLength = 2;
+    if (rest.compare(0, 2, "==") == 0) relation = op::eq;
+    else if (rest.compare(0, 2, "!=") == 0) relation = op::ne;
+    else if (rest.compare(0, 2, "<=") == 0) relation = op::le;
+    else if (rest.compare(0, 2, ">=") == 0) relation = op::ge;
+    else if (rest[0] == '<') { relation = op::lt; opLength = 1; }
+    else if (rest[0] == '>') { relation = op::gt; opLength = 1; }
+    else
+        throw std::invalid_argument("Unknown comparison in filter: " + expression);
+    value = parseValue(rest.substr(opLength), expression);
+}
+
+bool rowFilter::test(const size_t &row) const {
+    double x = table.values(col)[row];
+    if (modulus != 0)
+        x = std::fmod(x, modulus);
+    switch (relation) {
+    case op::eq: return x == value;
+    case op::ne: return x != value;
+    case op::lt: return x < value;
+    case op::le: return x <= value;
+    case op::gt: return x > value;
+    case op::ge: return x >= value;
+    }
+    return false;
+}
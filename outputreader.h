@@ -0,0 +1,71 @@
+#ifndef MILS_OUTPUTREADER_H
+#define MILS_OUTPUTREADER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "output.h"
+
+// Streaming access to the output tables written by simulate() (see output.h), for analysis without loading a whole
+// file: the file is memory-mapped and handed out in blocks of rows, so memory use does not grow with the file size.
+// Reads both the CSV layout (MGD_, Individual_Data, Stats_, cohort files) and binary .mcol files. Used by tools/milsquery.
+
+//Class def:
+// Read-only memory map of a whole file (POSIX mmap; elsewhere the file is read into memory instead)
+class mappedFile {
+public:
+    explicit mappedFile(const std::string &fileName);
+    ~mappedFile();
+    mappedFile(const mappedFile&) = delete;
+    mappedFile& operator=(const mappedFile&) = delete;
+
+    const char* data() const { return ptr; }
+    size_t size() const { return length; }
+
+private:
+    const char *ptr = nullptr;
+    size_t length = 0;
+    std::vector<char> copy;						// Contents, when the file could not be mapped
+};
+
+//Class def:
+// Rows of one output table, one block at a time. Values are doubles, as in tableSink; CSV columns are all float64.
+class tableReader {
+public:
+    virtual ~tableReader() = default;
+
+    const std::vector<column> &getColumns() const { return columns; }
+    size_t columnIndex(const std::string &name) const;	// Position of the column called 'name' (surrounding spaces ignored); throws if absent
+    virtual bool nextBlock() = 0;				// Load the next block of rows; false at the end of the table
+    size_t rows() const { return nRows; }		// Rows in the current block
+    const double* values(const size_t &col) const { return block[col].data(); }	// Column of the current block
+    virtual bool complete() const = 0;			// The whole table was written (not cut off by a running or crashed simulation)
+
+protected:
+    std::vector<column> columns;
+    size_t nRows = 0;
+    std::vector<std::vector<double>> block;		// Per column, values of the current block
+};
+
+// Open an output table; .mcol files are recognised by their magic bytes, anything else is read as CSV
+std::unique_ptr<tableReader> openTableReader(const std::string &fileName);
+
+// Row condition on one column: "<column> <op> <value>" or "<column> % <m> <op> <value>", op one of == != < <= > >=,
+// e.g. "Alive == 1" or "Generation % 5000 == 0"
+class rowFilter {
+public:
+    rowFilter(const tableReader &table, const std::string &expression);	// Throws std::invalid_argument on a bad expression
+    bool test(const size_t &row) const;			// Whether row 'row' of the current block of 'table' passes
+
+private:
+    enum class op { eq, ne, lt, le, gt, ge };
+
+    const tableReader &table;
+    size_t col;
+    double modulus = 0;							// 0 = compare the value itself
+    op relation;
+    double value;
+};
+
+#endif //MILS_OUTPUTREADER_H
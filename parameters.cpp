@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+#include <vector>
+#include "parameters.h"
+
+namespace {
+
+    using member = std::variant<int parameters::*, unsigned int parameters::*, unsigned long parameters::*,
+                                double parameters::*, generator parameters::*, mortalityLaw parameters::*, damageLaw parameters::*,
+                                std::string parameters::*>;
+
+    struct entry {
+        const char *section;	// Section header it is written under
+        const char *key;
+        member ptr;
+        const char *comment;
+    };
+
+    // Every configurable parameter, in the order they are written by writeConfig
+    const std::vector<entry> &entries() {
+        static const std::vector<entry> table = {
+            { "run", "nReplicates", &parameters::nReplicates, "Number of replicate simulations" },
+            { "run", "nThreads", &parameters::nThreads, "Worker threads (0 = one per hardware thread)" },
+            { "run", "storage", &parameters::storage, "Column types of the herd: double, or compact (float genes and damage, 16-bit ages; a third of the memory)" },
+            { "run", "chunkSize", &parameters::chunkSize, "Split every replicate's herd into chunks of this many slots, worked on in parallel (0 = no split)" },
+            { "run", "chunkThreads", &parameters::chunkThreads, "Threads per replicate for the chunks (0 = one per hardware thread)" },
+            { "run", "fixedSeed", &parameters::fixedSeed, "Master seed for reproducible runs (0 = drawn from std::random_device)" },
+            { "run", "bulkGenerator", &parameters::bulkGenerator, "Engine for the batched per-timestep random numbers (mt19937 or xoshiro256x4)" },
+            { "run", "bulkInit", &parameters::bulkInit, "Draw the initial genes in bulk from the bulk engine (0 = one normal() per gene, as before bulkInit)" },
+            { "run", "startPopulation", &parameters::startPopulation, "Population file (.pop, or a .ckpt) that replicates, sweep points and cohorts start from (empty = new population)" },
+            { "run", "savePopulation", &parameters::savePopulation, "Save every replicate's final population to <outputName><replicate>.pop, for startPopulation (1 = yes)" },
+            { "run", "outputName", &parameters::outputName, "Base name of the output files" },
+            { "run", "outputFormat", &parameters::outputFormat, "csv or binary (columnar .mcol files)" },
+            { "run", "asyncOutput", &parameters::asyncOutput, "Write output on a background thread per file (0 = inline)" },
+            { "run", "outputQueueBlocks", &parameters::outputQueueBlocks, "Blocks of 4096 rows queued for the writer thread before the simulation waits" },
+            { "run", "cohortEngine", &parameters::cohortEngine, "Engine for single cohorts: stepwise (every timestep) or events (sampled death times, much faster)" },
+            { "run", "checkpointInterval", &parameters::checkpointInterval, "Checkpoint every replicate each this many generations (0 = never)" },
+            { "run", "resume", &parameters::resume, "Continue replicates from their checkpoint files, if present (1 = yes)" },
+            { "run", "instrumentWindow", &parameters::instrumentWindow, "Generations per line of the timing breakdown in logfile.txt (-DMILS_INSTRUMENT builds)" },
+            { "run", "traceFile", &parameters::traceFile, "Chrome trace-event file of all timed stages (empty = none; -DMILS_INSTRUMENT builds)" },
+            { "run", "role", &parameters::role, "local, or coordinator / worker to spread replicates and sweep points over processes" },
+            { "run", "socketPath", &parameters::socketPath, "Unix socket of the coordinator" },
+            { "run", "localWorkers", &parameters::localWorkers, "Worker processes started by the coordinator itself (0 = only workers started by hand)" },
+            { "run", "taskAttempts", &parameters::taskAttempts, "Times a task is handed out again after its worker died, before the run fails" },
+
+            { "statistics", "statsInterval", &parameters::statsInterval, "Generations between rows of the MGD_ output (1 = every generation)" },
+            { "statistics", "detailedStats", &parameters::detailedStats, "Write means, variances and histograms of genes and damage to Stats_ files (1 = yes)" },
+            { "statistics", "histogramBins", &parameters::histogramBins, "Bins per histogram in the Stats_ files (0 = no histograms)" },
+            { "statistics", "histogramGeneRange", &parameters::histogramGeneRange, "Histograms of gen 2 and gen 3 cover [-range, range]; gen 1 covers [0, 1]" },
+            { "statistics", "histogramDamageMax", &parameters::histogramDamageMax, "Histograms of damage cover [0, max]" },
+
+            { "sweep", "sweep", &parameters::sweep, "Swept parameters, name:first:last:n,... (empty = run replicates instead)" },
+            { "sweep", "sweepDesign", &parameters::sweepDesign, "grid (full factorial) or lhs (Latin hypercube)" },
+            { "sweep", "sweepPoints", &parameters::sweepPoints, "Number of points of a Latin hypercube design" },
+
+            { "demes", "nDemes", &parameters::nDemes, "Demes (islands) of popSize / nDemes slots, parents drawn within the deme (1 = one panmictic population)" },
+            { "demes", "migrationInterval", &parameters::migrationInterval, "Generations between migrations (0 = never)" },
+            { "demes", "migrationRate", &parameters::migrationRate, "Fraction of every deme that migrates; migrants are shuffled over the slots they left" },
+            { "demes", "demeThreads", &parameters::demeThreads, "Threads per replicate for the demes (0 = one per hardware thread)" },
+
+            { "model", "popSize", &parameters::popSize, "(Initial) generation size" },
+            { "model", "intDeathRate", &parameters::intDeathRate, "Chance to die (lower is higher survivability); intrinsic death rate. Between 0 and 1." },
+            { "model", "extDeathRate", &parameters::extDeathRate, "Fraction individuals who die each timestep, extrinsic death. Between 0 and 1." },
+            { "model", "maxGens", &parameters::maxGens, "Maximum amount of generations allowed per simulation" },
+            { "model", "maxOffspring", &parameters::maxOffspring, "Maximum amount of offspring per individual" },
+            { "model", "alfa", &parameters::alfa, "Conversion factor for dependency offspring resources <-> number of offspring" },
+            { "model", "beta1", &parameters::beta1, "Factor (steepness) in Gompertz's law of mortality for damage of trait 1" },
+            { "model", "beta2", &parameters::beta2, "Factor (steepness) in Gompertz's law of mortality for damage of trait 2" },
+            { "model", "rho1", &parameters::rho1, "Factor (y-axis intersect) in Gompertz's law of mortality for damage of trait 1" },
+            { "model", "rho2", &parameters::rho2, "Factor (y-axis intersect) in Gompertz's law of mortality for damage of trait 2" },
+            { "model", "phi", &parameters::phi, "Steepness of linear mortality curve" },
+            { "model", "weibullScale", &parameters::weibullScale, "Damage at which the Weibull mortality curve reaches 1 - 1/e" },
+            { "model", "weibullShape", &parameters::weibullShape, "Shape (steepness) of the Weibull mortality curve" },
+            { "model", "mortalityModel", &parameters::mortalityModel, "Chance to die of each damage trait: gompertz (rho, beta), linear (phi) or weibull (weibullScale, weibullShape)" },
+            { "model", "damageModel", &parameters::damageModel, "Split of new damage over the traits: logistic (in gen 2 and gen 3) or even (half each)" },
+            { "model", "baseDamage", &parameters::baseDamage, "Damage added per timestep before allocation of repair/offspring resources" },
+
+            { "genes", "gen1Mean", &parameters::gen1Mean, "Mean for constructing genotype 1 from normal distribution (0 < Gen1 < 1)" },
+            { "genes", "gen1StdDev", &parameters::gen1StdDev, "Standard deviation for constructing genotype 1 from normal distribution" },
+            { "genes", "gen2Mean", &parameters::gen2Mean, "Mean for constructing genotype 2 from normal distribution" },
+            { "genes", "gen2StdDev", &parameters::gen2StdDev, "Standard deviation for constructing genotype 2 from normal distribution" },
+            { "genes", "gen3Mean", &parameters::gen3Mean, "Mean for constructing genotype 3 from normal distribution" },
+            { "genes", "gen3StdDev", &parameters::gen3StdDev, "Standard deviation for constructing genotype 3 from normal distribution" },
+
+            { "mutation", "mutationRateGen1", &parameters::mutationRateGen1, "Chance of mutating genotype 1 (0.01 = 1%)" },
+            { "mutation", "mutationRateGen2", &parameters::mutationRateGen2, "Chance of mutating genotype 2 (0.01 = 1%)" },
+            { "mutation", "mutationRateGen3", &parameters::mutationRateGen3, "Chance of mutating genotype 3 (0.01 = 1%)" },
+            { "mutation", "gen1MutationstdDev", &parameters::gen1MutationstdDev, "Standard deviation for mutations in gen 1" },
+            { "mutation", "gen2MutationstdDev", &parameters::gen2MutationstdDev, "Standard deviation for mutations in gen 2" },
+            { "mutation", "gen3MutationstdDev", &parameters::gen3MutationstdDev, "Standard deviation for mutations in gen 3" },
+        };
+        return table;
+    }
+
+    const entry &find(const std::string &key) {
+        for (const entry &e : entries())
+            if (key == e.key)
+                return e;
+        throw std::invalid_argument("Unknown parameter: " + key);
+    }
+
+    std::string trim(const std::string &s) {
+        size_t first = s.find_first_not_of(" \t\r");
+        if (first == std::string::npos)
+            return "";
+        size_t last = s.find_last_not_of(" \t\r");
+        return s.substr(first, last - first + 1);
+    }
+
+    size_t commentStart(const std::string &line) {		// '#' or '//' at the start of the line or after whitespace, so values may contain them
+        for (size_t i = 0; i < line.size(); ++i)
+            if ((line[i] == '#' || line.compare(i, 2, "//") == 0) && (i == 0 || line[i - 1] == ' ' || line[i - 1] == '\t'))
+                return i;
+        return std::string::npos;
+    }
+
+    template<typename T>
+    T parseNumber(const std::string &key, const std::string &value) {
+        std::istringstream is(value);
+        T x;
+        if (!(is >> x) || !(is >> std::ws).eof())
+            throw std::invalid_argument("Bad value for " + key + ": '" + value + "'");
+        return x;
+    }
+
+    template<typename T>
+    T parseLaw(const std::string &key, const std::string &value, std::initializer_list<T> laws) {
+        for (const T &law : laws)
+            if (value == lawName(law))
+                return law;
+        throw std::invalid_argument("Unknown " + key + ": " + value);
+    }
+
+    std::string formatDouble(const double &x) {	// Shortest text that reads back as exactly x
+        for (int precision = 6; precision <= 17; ++precision) {
+            std::ostringstream os;
+            os.precision(precision);
+            os << x;
+            if (std::stod(os.str()) == x)
+                return os.str();
+        }
+        return std::to_string(x);
+    }
+}
+
+void setParameter(parameters &p, const std::string &key, const std::string &value) {
+    const entry &e = find(key);
+    std::visit([&](auto ptr) {
+        using T = std::remove_reference_t<decltype(p.*ptr)>;
+        if constexpr (std::is_same_v<T, std::string>)
+            p.*ptr = value;
+        else if constexpr (std::is_same_v<T, generator>) {
+            if (value == generatorName(generator::mt19937))
+                p.*ptr = generator::mt19937;
+            else if (value == generatorName(generator::xoshiro256x4))
+                p.*ptr = generator::xoshiro256x4;
+            else
+                throw std::invalid_argument("Unknown generator: " + value);
+        }
+        else if constexpr (std::is_same_v<T, mortalityLaw>)
+            p.*ptr = parseLaw(key, value, { mortalityLaw::gompertz, mortalityLaw::linear, mortalityLaw::weibull });
+        else if constexpr (std::is_same_v<T, damageLaw>)
+            p.*ptr = parseLaw(key, value, { damageLaw::logistic, damageLaw::even });
+        else {
+            if (std::is_unsigned_v<T> && trim(value).rfind('-', 0) == 0)
+                throw std::invalid_argument("Bad value for " + key + ": '" + value + "'");
+            p.*ptr = parseNumber<T>(key, value);
+        }
+    }, e.ptr);
+}
+
+parameterKind kindOf(const std::string &key) {
+    return std::visit([](auto ptr) {
+        using T = std::remove_const_t<std::remove_reference_t<decltype(std::declval<parameters>().*ptr)>>;
+        if constexpr (std::is_integral_v<T>)
+            return parameterKind::integer;
+        else if constexpr (std::is_floating_point_v<T>)
+            return parameterKind::real;
+        else
+            return parameterKind::text;
+    }, find(key).ptr);
+}
+
+std::string getParameter(const parameters &p, const std::string &key) {
+    const entry &e = find(key);
+    return std::visit([&](auto ptr) -> std::string {
+        using T = std::remove_const_t<std::remove_reference_t<decltype(p.*ptr)>>;
+        if constexpr (std::is_same_v<T, std::string>)
+            return p.*ptr;
+        else if constexpr (std::is_same_v<T, generator>)
+            return generatorName(p.*ptr);
+        else if constexpr (std::is_same_v<T, mortalityLaw> || std::is_same_v<T, damageLaw>)
+            return lawName(p.*ptr);
+        else if constexpr (std::is_same_v<T, double>)
+            return formatDouble(p.*ptr);
+        else
+            return std::to_string(p.*ptr);
+    }, e.ptr);
+}
+
+void loadConfig(parameters &p, const std::string &fileName) {
+    std::ifstream ifs(fileName);
+    if (!ifs.is_open())
+        throw std::runtime_error("Cannot open config file: " + fileName);
+    readConfig(p, ifs, fileName);
+}
+
+void readConfig(parameters &p, std::istream &is, const std::string &source) {
+    std::string line;
+    int lineNr = 0;
+    while (std::getline(is, line)) {
+        ++lineNr;
+        line = trim(line.substr(0, commentStart(line)));
+        if (line.empty() || line.front() == '[')			// Blank, comment or [section] header
+            continue;
+
+        size_t eq = line.find('=');
+        if (eq == std::string::npos)
+            throw std::invalid_argument(source + ":" + std::to_string(lineNr) + ": expected key = value");
+        setParameter(p, trim(line.substr(0, eq)), trim(line.substr(eq + 1)));
+    }
+}
+
+void parseCommandLine(parameters &p, const int &argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--config") {
+            if (i + 1 >= argc)
+                throw std::invalid_argument("--config needs a file name");
+            loadConfig(p, argv[++i]);
+        }
+        else {
+            size_t eq = arg.find('=');
+            if (eq == std::string::npos)
+                throw std::invalid_argument("Expected key=value or --config <file>, got: " + arg);
+            std::string key = arg.substr(0, eq);
+            if (key.rfind("--", 0) == 0)						// Accept --key=value as well
+                key = key.substr(2);
+            setParameter(p, key, arg.substr(eq + 1));
+        }
+    }
+}
+
+void writeConfig(const parameters &p, std::ostream &os) {
+    std::string section;
+    for (const entry &e : entries()) {
+        if (section != e.section) {
+            if (!section.empty())
+                os << std::endl;
+            section = e.section;
+            os << "[" << section << "]" << std::endl;
+        }
+        std::string line = std::string(e.key) + " = " + getParameter(p, e.key);
+        line.resize(std::max<size_t>(line.size() + 1, 40), ' ');	// At least one space, or the comment would be read as part of the value
+        os << line << "# " << e.comment << std::endl;
+    }
+}
+
+const char* lawName(const mortalityLaw &m) {
+    switch (m) {
+    case mortalityLaw::gompertz: return "gompertz";
+    case mortalityLaw::linear:   return "linear";
+    case mortalityLaw::weibull:  return "weibull";
+    }
+    return "unknown";
+}
+
+const char* lawName(const damageLaw &d) {
+    switch (d) {
+    case damageLaw::logistic: return "logistic";
+    case damageLaw::even:     return "even";
+    }
+    return "unknown";
+}
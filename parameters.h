@@ -0,0 +1,118 @@
+#ifndef MILS_PARAMETERS_H
+#define MILS_PARAMETERS_H
+
+#include <string>
+#include <iostream>
+#include "randomnumbers.h"
+
+// Laws of the model that can be swapped by a config key; each is a policy type compiled into the kernels (see models.h)
+enum class mortalityLaw { gompertz, linear, weibull };		// Chance to die from the damage of one trait
+enum class damageLaw { logistic, even };					// Split of new damage over the two traits
+const char* lawName(const mortalityLaw &m);
+const char* lawName(const damageLaw &d);
+
+// All settings of a run. Defaults below; override them with a key = value config file and/or
+// key=value command line arguments (see parseCommandLine). Keys are the member names.
+struct parameters {
+    //Run settings
+    int nReplicates = 10;					// Number of independent replicate simulations run by main()
+    unsigned int nThreads = 0;				// Worker threads for running replicates (0 = one per hardware thread)
+    std::string storage = "double";			// Column types of the herd: "double", or "compact" (float genes and damage, 16-bit ages; see herd.h)
+    unsigned long chunkSize = 0;			// Split every replicate's herd into chunks of this many slots, worked on in parallel (0 = no split; see herdchunks.h)
+    unsigned int chunkThreads = 0;			// Threads per replicate for the chunks (0 = one per hardware thread)
+    unsigned int fixedSeed = 0;				// Master seed for reproducible runs (0 = fresh seed from std::random_device)
+    generator bulkGenerator = generator::xoshiro256x4;	// Engine for the batched per-timestep random numbers
+    int bulkInit = 1;						// Draw the initial genes in bulk, column by column (0 = one normal() per gene, as before bulkInit)
+    std::string startPopulation = "";		// Start from the population in this .pop or .ckpt file instead of a new one (empty = new)
+    int savePopulation = 0;					// Save every replicate's population after its last generation to <name>.pop (1 = yes)
+    std::string outputName = "Gomp+Gomp_simulation";	// Base name of the output files
+    std::string outputFormat = "csv";		// "csv" (text) or "binary" (columnar .mcol files, see output.h; convert with tools/mcol2csv)
+    int asyncOutput = 1;					// Format and write output on a background thread per file (0 = inline)
+    int outputQueueBlocks = 8;				// Blocks of 4096 rows that may wait for the writer thread before the simulation waits
+    std::string cohortEngine = "stepwise";	// Engine for single cohorts (iterate, last generation, sweeps): "stepwise" or "events" (see cohortevents.h)
+    int checkpointInterval = 0;				// Save a checkpoint of every replicate each this many generations (0 = never)
+    int resume = 0;							// Continue replicates from their checkpoint files, if present (1 = yes)
+    int instrumentWindow = 1000;			// Generations per line of the timing breakdown in logfile.txt (needs a -DMILS_INSTRUMENT build)
+    std::string traceFile = "";				// Chrome trace-event file of all timed stages (empty = none; needs a -DMILS_INSTRUMENT build)
+    std::string role = "local";				// "local" (all tasks in this process), "coordinator" or "worker" (tasks spread over processes; see distributed.h)
+    std::string socketPath = "mils.sock";	// Unix socket the coordinator listens on and workers connect to
+    unsigned int localWorkers = 0;			// Worker processes the coordinator starts itself (0 = only workers started by hand)
+    int taskAttempts = 3;					// Times the coordinator hands out a task whose worker died, before giving up
+
+    //Statistics
+    int statsInterval = 50;					// Generations between rows of the MGD_ output (1 = every generation)
+    int detailedStats = 0;					// Also write means, variances and histograms of genes and damage to Stats_ files (1 = yes)
+    int histogramBins = 20;					// Bins per histogram in the Stats_ files (0 = no histograms)
+    double histogramGeneRange = 5.0;		// Histograms of gen 2 and gen 3 cover [-range, range]; gen 1 covers [0, 1]
+    double histogramDamageMax = 10.0;		// Histograms of damage cover [0, max]
+
+    //Parameter sweep (replaces the replicate runs when 'sweep' is set)
+    std::string sweep = "";					// Swept parameters, "name:first:last:n,..." (empty = no sweep; n is not needed for lhs)
+    std::string sweepDesign = "grid";		// "grid" (full factorial) or "lhs" (Latin hypercube of sweepPoints points)
+    int sweepPoints = 100;					// Number of points of a Latin hypercube design
+
+    //Population structure (island model; see herddemes.h)
+    unsigned int nDemes = 1;				// Demes (islands) of popSize / nDemes slots; parents come from the same deme (1 = one panmictic population)
+    int migrationInterval = 10;				// Generations between migrations (0 = never)
+    double migrationRate = 0.01;			// Fraction of every deme that migrates at a migration
+    unsigned int demeThreads = 0;			// Threads per replicate for the demes (0 = one per hardware thread)
+
+    //Model
+    unsigned long popSize = 5000;			// (Initial) generation size
+    double intDeathRate = 0.5;				// Chance to die (lower is higher survivability); intrinsic death rate.
+    double extDeathRate = 0.01;				// Fraction individuals who die each timestep, extrinsic death
+    int maxGens = 100000;					// Maximum amount of generation allowed per simulation
+    double maxOffspring = 3.0;				// Max number of offspring allowed per individual
+    double alfa = 0.4;						// Conversion rate for dependency resources invested in offspring <-> actual offspring
+    double beta1 = 2.0;						// Factor (steepness) in Gompertz's law of mortality for damage of trait 1
+    double beta2 = 2.0;						// Factor (steepness) in Gompertz's law of mortality for damage of trait 2
+    double rho1 = 5.0;						// Factor (y-axis intersect) in Gompertz's law of mortality for damage of trait 1
+    double rho2 = 15.0;						// Factor (y-axis intersect) in Gompertz's law of mortality for damage of trait 2
+    double phi = 0.33;						// Steepness of linear mortality curve
+    double weibullScale = 1.0;				// Damage at which the Weibull mortality curve reaches 1 - 1/e
+    double weibullShape = 2.0;				// Shape (steepness) of the Weibull mortality curve
+    mortalityLaw mortalityModel = mortalityLaw::gompertz;	// Chance to die of each damage trait: gompertz (rho, beta), linear (phi) or weibull (weibullScale, weibullShape)
+    damageLaw damageModel = damageLaw::logistic;			// Split of new damage: logistic (in gen 2 and gen 3) or even (half to each trait)
+    double baseDamage = 0.1;				// Standard amount of damage added per timestep before allocation of repair/offspring resources
+
+    //Genotype initialisation				0 < Gen1 < 1 ;;; -inf < Gen2 < +inf ;;; -inf < Gen3 < +inf
+    double gen1Mean = 0.5;					// Mean for constructing gene 1 from normal distribution
+    double gen1StdDev = 0.05;				// Standard deviation for constructing genotype 1 from normal distribution
+    double gen2Mean = 0.0;					// Mean for constructing gene 2 from normal distribution
+    double gen2StdDev = 0.1;				// Standard deviation for constructing genotype 2 from normal distribution
+    double gen3Mean = 0.0;					// Mean for constructing gene 3 from normal distribution
+    double gen3StdDev = 0.1;				// Standard deviation for constructing genotype 3 from normal distribution
+
+    //Mutation
+    double mutationRateGen1 = 0.01;			// Rate of mutation for gen 1
+    double mutationRateGen2 = 0.05;			// Rate of mutation for gen 2
+    double mutationRateGen3 = 0.05;			// Rate of mutation for gen 3
+    double gen1MutationstdDev = 0.05;		// Standard deviation for mutation in gen 1
+    double gen2MutationstdDev = 0.5;		// Standard deviation for mutation in gen 2
+    double gen3MutationstdDev = 0.5;		// Standard deviation for mutation in gen 3
+};
+
+// Set parameter 'key' from its text value; throws std::invalid_argument on unknown keys or bad values
+void setParameter(parameters &p, const std::string &key, const std::string &value);
+
+// Current value of parameter 'key' as text, in the format read back by setParameter
+std::string getParameter(const parameters &p, const std::string &key);
+
+// Kind of value parameter 'key' takes (text: strings, generators and laws); throws std::invalid_argument on unknown keys
+enum class parameterKind { integer, real, text };
+parameterKind kindOf(const std::string &key);
+
+// Read a config file: one key = value per line, '#' and '//' at the start of a line or after whitespace start comments
+// (so values like run#1 or /tmp//mils.sock are read whole), [section] lines are ignored
+void loadConfig(parameters &p, const std::string &fileName);
+
+// The same from a stream; 'source' names it in error messages
+void readConfig(parameters &p, std::istream &is, const std::string &source);
+
+// Apply command line arguments in order: "--config <file>" loads a file, "key=value" overrides one parameter
+void parseCommandLine(parameters &p, const int &argc, char *argv[]);
+
+// Write every parameter in the format read by loadConfig
+void writeConfig(const parameters &p, std::ostream &os);
+
+#endif //MILS_PARAMETERS_H
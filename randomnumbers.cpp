@@ -1,21 +1,42 @@
 #include <iostream>
 #include <chrono>
 #include <random>
+#include <stdexcept>
+#include <cmath>
 #include "randomnumbers.h"
+#include "instrumentation.h"
 
-std::mt19937 rng;
+thread_local std::mt19937 rng;
+thread_local xoshiro256x4 bulkRng;
+thread_local generator bulkGenerator = generator::xoshiro256x4;
 
-long randomize() {
+long randomize(const unsigned int &fixedSeed) {
     static std::random_device rd{};
-    auto seed = rd();
+    unsigned int seed = fixedSeed ? fixedSeed : rd();
     std::cout << "Used seed: "<< seed << std::endl;
-    rng.seed(seed);
+    seedRng(seed);
+    return seed;
+}
+
+unsigned int replicateSeed(const unsigned int &masterSeed, const int &replicate)
+{
+    std::seed_seq seq{ masterSeed, static_cast<unsigned int>(replicate) };	// Mixes both values, so neighbouring replicates get unrelated seeds
+    unsigned int seed;
+    seq.generate(&seed, &seed + 1);
     return seed;
 }
 
+void seedRng(const unsigned int &seed, const generator &bulk)
+{
+    rng.seed(seed);
+    bulkRng.reseed(seed);
+    bulkGenerator = bulk;
+}
+
 // random integer {0,...,n} (including n)
 int rn(const int &n)
 {
+    MILS_COUNT(counter::rngDraws, 1);
     std::uniform_int_distribution<> d{};
     using parm_t = decltype(d)::param_type;
     return d(rng, parm_t{ 0,n });
@@ -24,6 +45,7 @@ int rn(const int &n)
 // random double [0,1)
 double ru()
 {
+    MILS_COUNT(counter::rngDraws, 1);
     std::uniform_real_distribution<> d{};
     return d(rng);
 }
@@ -31,6 +53,7 @@ double ru()
 // random standard normal
 double normal(const double &mean, const double &stddev)
 {
+    MILS_COUNT(counter::rngDraws, 1);
     std::normal_distribution<> d{mean, stddev};
     return d(rng);
 }
@@ -38,12 +61,14 @@ double normal(const double &mean, const double &stddev)
 // random bernoulli {0,1}
 bool r2()
 {
+    MILS_COUNT(counter::rngDraws, 1);
     static std::bernoulli_distribution d{};
     return d(rng);
 }
 
 int rpois(const double &lambda)
 {
+    MILS_COUNT(counter::rngDraws, 1);
     std::poisson_distribution<> d{};
     using parm_t = decltype(d)::param_type;
     return d(rng, parm_t{lambda});
@@ -51,6 +76,7 @@ int rpois(const double &lambda)
 
 double rexp(const double &lambda)
 {
+    MILS_COUNT(counter::rngDraws, 1);
     std::exponential_distribution<> d{};
     using parm_t = decltype(d)::param_type;
     return d(rng, parm_t{ lambda });
@@ -58,6 +84,194 @@ double rexp(const double &lambda)
 
 int rindex(const std::vector<double> &w)
 {
-    std::discrete_distribution<> ri(begin(w), end(w));
-    return(ri(rng));
+    aliasTable ri(w);
+    return(ri.draw());
+}
+
+void aliasTable::build(const std::vector<double> &w)
+{
+    const size_t n = w.size();
+    if (n == 0)
+        throw std::invalid_argument("aliasTable: empty weight vector");
+
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        if (w[i] < 0.0)
+            throw std::invalid_argument("aliasTable: negative weight");
+        sum += w[i];
+    }
+    if (sum <= 0.0)
+        throw std::invalid_argument("aliasTable: weights sum to zero");
+
+    prob.resize(n);
+    alias.resize(n);
+    small.clear();
+    large.clear();
+    small.reserve(n);							// Worklists never outgrow n, so rebuilding for the same n allocates nothing
+    large.reserve(n);
+
+    for (size_t i = 0; i < n; ++i) {			// Scale weights so that the average column height is 1
+        prob[i] = w[i] * n / sum;
+        alias[i] = static_cast<int>(i);
+        if (prob[i] < 1.0)
+            small.push_back(static_cast<int>(i));
+        else
+            large.push_back(static_cast<int>(i));
+    }
+
+    while (!small.empty() && !large.empty()) {	// Fill each short column with the excess of a tall one
+        int s = small.back(); small.pop_back();
+        int l = large.back();
+        alias[s] = l;
+        prob[l] -= 1.0 - prob[s];
+        if (prob[l] < 1.0) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    for (int l : large) prob[l] = 1.0;		// Leftovers are full columns (up to rounding error)
+    for (int s : small) prob[s] = 1.0;
+}
+
+int aliasTable::draw() const
+{
+    return draw(ru());
+}
+
+int aliasTable::draw(const double &u) const
+{
+    const size_t n = prob.size();
+    double x = u * n;							// One uniform gives both the column and the coin flip
+    size_t i = static_cast<size_t>(x);
+    if (i >= n) i = n - 1;
+    return (x - i) < prob[i] ? static_cast<int>(i) : alias[i];
+}
+
+static inline uint64_t rotl(const uint64_t &x, const int &k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t splitmix64(uint64_t &x)
+{
+    uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void xoshiro256x4::reseed(uint64_t seed)
+{
+    for (int l = 0; l < 4; ++l) {
+        s0[l] = splitmix64(seed);
+        s1[l] = splitmix64(seed);
+        s2[l] = splitmix64(seed);
+        s3[l] = splitmix64(seed);
+    }
+}
+
+void xoshiro256x4::next4(uint64_t *out)
+{
+    for (int l = 0; l < 4; ++l) {
+        out[l] = rotl(s1[l] * 5, 7) * 9;
+        const uint64_t t = s1[l] << 17;
+        s2[l] ^= s0[l];
+        s3[l] ^= s1[l];
+        s1[l] ^= s2[l];
+        s0[l] ^= s3[l];
+        s2[l] ^= t;
+        s3[l] = rotl(s3[l], 45);
+    }
+}
+
+void xoshiro256x4::fillUniform(double *out, const size_t &n)
+{
+    uint64_t block[4];
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        next4(block);
+        for (int l = 0; l < 4; ++l)
+            out[i + l] = (block[l] >> 11) * 0x1.0p-53;
+    }
+    if (i < n) {								// Tail: use part of one more block
+        next4(block);
+        for (int l = 0; i < n; ++i, ++l)
+            out[i] = (block[l] >> 11) * 0x1.0p-53;
+    }
+}
+
+void xoshiro256x4::getState(uint64_t *state) const
+{
+    for (int l = 0; l < 4; ++l) {
+        state[l] = s0[l];
+        state[4 + l] = s1[l];
+        state[8 + l] = s2[l];
+        state[12 + l] = s3[l];
+    }
+}
+
+void xoshiro256x4::setState(const uint64_t *state)
+{
+    for (int l = 0; l < 4; ++l) {
+        s0[l] = state[l];
+        s1[l] = state[4 + l];
+        s2[l] = state[8 + l];
+        s3[l] = state[12 + l];
+    }
+}
+
+const char* generatorName(const generator &g)
+{
+    switch (g) {
+    case generator::mt19937:      return "mt19937";
+    case generator::xoshiro256x4: return "xoshiro256x4";
+    }
+    return "unknown";
+}
+
+void fillUniform(std::vector<double> &out, const size_t &n)
+{
+    MILS_COUNT(counter::rngDraws, n);
+    out.resize(n);
+    if (bulkGenerator == generator::xoshiro256x4) {
+        bulkRng.fillUniform(out.data(), n);
+    }
+    else {
+        for (size_t i = 0; i < n; ++i)
+            out[i] = std::generate_canonical<double, 53>(rng);
+    }
+}
+
+static void boxMuller(std::vector<double> &out, const size_t &n)
+{
+    // out holds 2 * ceil(n / 2) uniforms; turn each pair into two standard normals, then drop the spare one
+    const size_t nPairs = out.size() / 2;
+    const double twoPi = 6.283185307179586;
+    for (size_t p = 0; p < nPairs; ++p) {
+        double u1 = 1.0 - out[2 * p];			// (0,1], so the log is finite
+        double u2 = out[2 * p + 1];
+        double r = std::sqrt(-2.0 * std::log(u1));
+        out[2 * p] = r * std::cos(twoPi * u2);
+        out[2 * p + 1] = r * std::sin(twoPi * u2);
+    }
+    out.resize(n);
+}
+
+void fillNormal(std::vector<double> &out, const size_t &n)
+{
+    fillUniform(out, 2 * ((n + 1) / 2));		// Two uniforms per pair of normals, transformed in place
+    boxMuller(out, n);
+}
+
+void fillUniform(xoshiro256x4 &engine, std::vector<double> &out, const size_t &n)
+{
+    MILS_COUNT(counter::rngDraws, n);
+    out.resize(n);
+    engine.fillUniform(out.data(), n);
+}
+
+void fillNormal(xoshiro256x4 &engine, std::vector<double> &out, const size_t &n)
+{
+    fillUniform(engine, out, 2 * ((n + 1) / 2));
+    boxMuller(out, n);
 }
\ No newline at end of file
@@ -2,8 +2,20 @@
 #define MILS_RANDOMNUMBERS_H
 
 #include <random>
+#include <vector>
+#include <cstdint>
 
-long randomize();
+// seed this thread's engines with 'fixedSeed', or with a fresh seed from std::random_device if fixedSeed == 0
+long randomize(const unsigned int &fixedSeed = 0);
+
+// seed of replicate 'replicate', derived from the master seed; independent of thread count/scheduling
+unsigned int replicateSeed(const unsigned int &masterSeed, const int &replicate);
+
+enum class generator { mt19937, xoshiro256x4 };
+const char* generatorName(const generator &g);
+
+// (re)seed the calling thread's engines (scalar and bulk), and select the engine used by fillUniform/fillNormal
+void seedRng(const unsigned int &seed, const generator &bulk = generator::xoshiro256x4);
 
 // random integer [0,n]
 int rn(const int&);
@@ -24,9 +36,58 @@ int rpois(const double&);
 double rexp(const double&);
 
 // generate random index based on vector of int weights 
-// may template this later...
+// thin wrapper around aliasTable; build an aliasTable directly when drawing repeatedly from the same weights
 int rindex(const std::vector<double> &w);
 
-extern std::mt19937 rng;
+// Walker/Vose alias table: O(n) build, O(1) weighted index draws
+class aliasTable {
+public:
+    aliasTable() = default;
+    explicit aliasTable(const std::vector<double> &w) { build(w); }
+
+    void build(const std::vector<double> &w);	// (Re)build table from weights; reuses allocated storage
+    int draw() const;							// Draw index i with probability w[i] / sum(w)
+    int draw(const double &u) const;			// Same, using a given uniform [0,1) instead of calling ru()
+    size_t size() const { return prob.size(); }
+
+private:
+    std::vector<double> prob;		// Probability of keeping column i instead of jumping to its alias
+    std::vector<int> alias;			// Alias index of column i
+    std::vector<int> small;			// Scratch worklists for build()
+    std::vector<int> large;
+};
+
+// Four interleaved xoshiro256** streams. Each step advances all four lanes with the same
+// shift/rotate/multiply sequence, so filling a buffer compiles to SIMD code.
+class xoshiro256x4 {
+public:
+    explicit xoshiro256x4(const uint64_t &seed = 0) { reseed(seed); }
+    void reseed(uint64_t seed);					// Expand seed into 16 state words with splitmix64
+    void next4(uint64_t *out);					// Next value of each lane
+    void fillUniform(double *out, const size_t &n);	// n uniforms [0,1) with 53 random bits each
+    void getState(uint64_t *state) const;		// Copy out / restore the 16 state words (for checkpoints)
+    void setState(const uint64_t *state);
+
+private:
+    uint64_t s0[4], s1[4], s2[4], s3[4];
+};
+
+// Bulk generation, used by the per-timestep kernels instead of one distribution object per draw.
+// Draws from the calling thread's engine selected by seedRng().
+
+// resize 'out' to n and fill with uniforms [0,1)
+void fillUniform(std::vector<double> &out, const size_t &n);
+
+// resize 'out' to n and fill with standard normals (Box-Muller)
+void fillNormal(std::vector<double> &out, const size_t &n);
+
+// Same, drawing from a given engine instead of the calling thread's; for streams owned by a chunk of work
+void fillUniform(xoshiro256x4 &engine, std::vector<double> &out, const size_t &n);
+void fillNormal(xoshiro256x4 &engine, std::vector<double> &out, const size_t &n);
+
+// every thread owns its own engines; all functions above draw from the calling thread's engines
+extern thread_local std::mt19937 rng;
+extern thread_local xoshiro256x4 bulkRng;
+extern thread_local generator bulkGenerator;
 
 #endif //MILS_RANDOMNUMBERS_H
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <stdexcept>
 #include <cmath>
 #include "sheep.h"
+#include "models.h"
 
 
 sheep::sheep() {						// Constructor called upon initialization -> 'birth'
@@ -8,12 +9,12 @@ sheep::sheep() {						// Constructor called upon initialization -> 'birth'
     damageTrait1 = 0.0001;				// Individual starts life with minimal amount of damage;
     damageTrait2 = 0.0001;               // this is above zero to prevent division by zero (in the addDamage function).
     alive = true;
-    repairResources = gen1;				// Set resources invested in repair
-    offspringResources = (1 - gen1);	// Remaining resources are invested in offspring
+    deathCause = -1;					// Not dead (yet)
+    gen1 = gen2 = gen3 = 0.0;			// Genes are set by setGen1/2/3; repair resources follow gen1
 }
 
-void sheep::setGen1(const double &setManual /* = 0 */) { // If default argument is given (setManual), gene value equals this argument. Else, value taken from normal distribution
-    setManual ? gen1 = setManual : gen1 = normal(gen1Mean, gen1StdDev);
+void sheep::setGen1(const parameters &p, const double &setManual /* = 0 */) { // If default argument is given (setManual), gene value equals this argument. Else, value taken from normal distribution
+    setManual ? gen1 = setManual : gen1 = normal(p.gen1Mean, p.gen1StdDev);
 
     if (gen1 < 0)		// Gen 1 is restricted to be between 0 and 1
         gen1 = 0;
@@ -21,44 +22,47 @@ void sheep::setGen1(const double &setManual /* = 0 */) { // If default argument
         gen1 = 1;
 }
 
-void sheep::setGen2(const double &setManual /* = 0 */) { // If default argument is given (setManual), gene value equals this argument. Else, value taken from normal distribution
-    setManual ? gen2 = setManual : gen2 = normal(gen2Mean, gen2StdDev);
+void sheep::setGen2(const parameters &p, const double &setManual /* = 0 */) { // If default argument is given (setManual), gene value equals this argument. Else, value taken from normal distribution
+    setManual ? gen2 = setManual : gen2 = normal(p.gen2Mean, p.gen2StdDev);
 }
 
-void sheep::setGen3(const double &setManual /* = 0 */) { // If default argument is given (setManual), gene value equals this argument. Else, value taken from normal distribution
-    setManual ? gen3 = setManual : gen3 = normal(gen3Mean, gen3StdDev);
+void sheep::setGen3(const parameters &p, const double &setManual /* = 0 */) { // If default argument is given (setManual), gene value equals this argument. Else, value taken from normal distribution
+    setManual ? gen3 = setManual : gen3 = normal(p.gen3Mean, p.gen3StdDev);
 }
 
-void sheep::kill() { // Calculate survival rate based on damage, and kill sheep accordingly
-    if (ru() < extDeathRate) {									// External deathRate
+void sheep::kill(const parameters &p) { // Calculate survival rate based on damage, and kill sheep accordingly
+    if (ru() < p.extDeathRate) {									// External deathRate
         alive = false;
         deathCause = 0;
     }
-    else if (ru() < 1 * exp(-rho1 * exp(-beta1 * damageTrait1))) {	// Internal death rate for damage 1 -> Gompertz law of mortality
-        alive = false;
-        deathCause = 1;
-    }
-
-    else if (ru() < 1 * exp(-rho2 * exp(-beta2 * damageTrait2))) {	// Internal death rate for damage 2 -> Gompertz law of mortality
-        alive = false;
-        deathCause = 2;
+    else {
+        withMortality(p, [this](const auto &mortality1, const auto &mortality2) {
+            if (ru() < mortality1(damageTrait1)) {					// Internal death rate for damage 1, e.g. Gompertz law of mortality
+                alive = false;
+                deathCause = 1;
+            }
+            else if (ru() < mortality2(damageTrait2)) {				// Internal death rate for damage 2
+                alive = false;
+                deathCause = 2;
+            }
+        });
     }
 }
 
-void sheep::addDamage() {
-    double baseDam = baseDamage * (1 - repairResources);				// Initial baseDamage scaled to amount of resources invested in damage prevention
+void sheep::addDamage(const parameters &p) {
+    double baseDam = p.baseDamage * (1 - gen1);				// Initial baseDamage scaled to amount of resources invested in damage prevention
     double damageAllocation;
 
     double relativeDamage = ((damageTrait1 - damageTrait2) / (damageTrait1 + damageTrait2));
-    damageAllocation = (1 / (1 + exp(-gen2 * relativeDamage + gen3)));	//And allocation of resources accordingly
+    damageAllocation = withDamage(p, [this, relativeDamage](const auto &allocation) { return allocation(gen2, gen3, relativeDamage); });	//And allocation of resources accordingly
 
     damageTrait1 += damageAllocation * baseDam;						// Scale incoming damage to resources allocated
     damageTrait2 += (1 - damageAllocation) * baseDam;
 }
 
-void sheep::mutateGen1() { // Add mutation to gen 1. Restrictions: 0 > gen 1 > 1
-    if (ru() < mutationRateGen1) {							// if mutationRateGen1 = 0.01, 1% of population mutates
-        double mutation = normal(0, gen1MutationstdDev);	// Generate mutation. Standard deviation specified in globals.cpp 
+void sheep::mutateGen1(const parameters &p) { // Add mutation to gen 1. Restrictions: 0 > gen 1 > 1
+    if (ru() < p.mutationRateGen1) {							// if mutationRateGen1 = 0.01, 1% of population mutates
+        double mutation = normal(0, p.gen1MutationstdDev);	// Generate mutation. Standard deviation specified in parameters 
         double mutatedGen1 = mutation + gen1;				// Add mutation to gene value .. 
         if (mutatedGen1 > 1)								// .. And apply restrictions
             gen1 = 1;
@@ -69,16 +73,16 @@ void sheep::mutateGen1() { // Add mutation to gen 1. Restrictions: 0 > gen 1 > 1
     }
 }
 
-void sheep::mutateGen2() { // Add mutation to gen 2. No restriction to gene value
-    if (ru() < mutationRateGen2) {
-        double mutation = normal(0, gen2MutationstdDev);
+void sheep::mutateGen2(const parameters &p) { // Add mutation to gen 2. No restriction to gene value
+    if (ru() < p.mutationRateGen2) {
+        double mutation = normal(0, p.gen2MutationstdDev);
         gen2 += mutation;
     }
 }
 
-void sheep::mutateGen3() { // Add mutation to gen 3
-    if (ru() < mutationRateGen3) {
-        double mutation = normal(0, gen3MutationstdDev);
+void sheep::mutateGen3(const parameters &p) { // Add mutation to gen 3
+    if (ru() < p.mutationRateGen3) {
+        double mutation = normal(0, p.gen3MutationstdDev);
         gen3 += mutation;
     }
 }
\ No newline at end of file
@@ -0,0 +1,458 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <cstdio>
+#include "simulation.h"
+#include "output.h"
+#include "checkpoint.h"
+#include "cohortevents.h"
+#include "allocations.h"
+#include "instrumentation.h"
+#include "threadpool.h"
+#include "herdchunks.h"
+#include "herddemes.h"
+#include "randomnumbers.h"
+
+// Function definitions:
+
+herd initiatePopulation(const parameters &p) {
+    // Initiate the starting population, of size 'popSize', or take it from a saved population
+    if (!p.startPopulation.empty()) {
+        herd saved = readCheckpoint(p.startPopulation).vHerd;
+        if (saved.size() != p.popSize)
+            throw std::invalid_argument("startPopulation " + p.startPopulation + " has " + std::to_string(saved.size()) + " individuals; set popSize to match");
+        return saved;
+    }
+    herd generation(p.popSize);
+    generation.initiate(p);			// Give every individual gene values for all three genes, in place
+    return generation;
+}
+
+void runCohort(const parameters &p, herd vHerd, const std::function<void(const cohortStats&)> &onTimestep) {
+    // Let a cohort run until all sheep are dead. No reproduction / mutations
+
+    if (p.cohortEngine == "events") {				// Sample death times directly instead; see cohortevents.h
+        runCohortEvents(p, std::move(vHerd), onTimestep);
+        return;
+    }
+    if (p.cohortEngine != "stepwise")
+        throw std::invalid_argument("Unknown cohortEngine: " + p.cohortEngine + " (use stepwise or events)");
+
+    if (vHerd.size() == 0) {						// If given herd is empty..
+        vHerd = initiatePopulation(p);				//..initiate a new population, and proceed
+    }
+
+    cohortStats s;
+    s.time = 0;
+    herdStats stats(p);
+    stats.rebuild(vHerd);
+
+    do {
+        vHerd.addDamage(p);										// Add random small amount of damage to every living sheep
+        vHerd.kill(p, &stats);									// And kill sheep according to their damage, collecting data on the way
+        s.gen1Total = stats.genAlive[0].sum();					// Living
+        s.gen2Total = stats.genAlive[1].sum();
+        s.gen3Total = stats.genAlive[2].sum();
+        s.damage1Alive = stats.damageAlive[0].sum();
+        s.damage2Alive = stats.damageAlive[1].sum();
+        s.iAlive = stats.nAlive();
+        s.damage1Dead = stats.damageDead[0].value();			// Died this timestep
+        s.damage2Dead = stats.damageDead[1].value();
+        s.iDead = stats.nDead;
+        vHerd.advanceAge(&stats);
+
+        onTimestep(s);
+
+        ++s.time;
+    } while (s.iAlive > 0 && s.time < p.maxGens);	    // End simulation if all sheep are dead,
+    // or maximum nr. of simulations is reached
+}
+
+void iterate(const parameters &p, std::string outputFileName, double parameter, herd vHerd) {
+    // Build a starting cohort, and let simulation run until all sheep are dead. No reproduction / mutations
+
+    std::string fileName;
+    if (outputFileName == "") {						// If empty string (no argument given)
+        fileName = "singleGen";
+    }
+    else {											// Else if argument was given, make argument + value of parameter name of output file
+        fileName = outputFileName + std::to_string(parameter);
+    }
+
+    std::unique_ptr<tableSink> initialGeneration = openTable(p, fileName, cohortColumns(), ", ");	// Open output sink for data storage
+
+    runCohort(p, std::move(vHerd), [&](const cohortStats &s) {
+        initialGeneration->addRow(cohortRow(s).data());	// Output
+    });
+    initialGeneration->close();
+}
+
+std::vector<column> cohortColumns() {
+    return { { "Time", columnType::int32 }, { "totalGen1", columnType::float64 }, { "totalGen2", columnType::float64 },
+             { "totalGen3", columnType::float64 }, { "dAlive", columnType::int32 }, { "Damage1Alive", columnType::float64 },
+             { "Damage2Alive", columnType::float64 }, { "NrDead", columnType::int32 }, { "Damage1Dead", columnType::float64 },
+             { "Damage2Dead", columnType::float64 } };
+}
+
+std::array<double, 10> cohortRow(const cohortStats &s) {
+    return { double(s.time), s.gen1Total, s.gen2Total, s.gen3Total, double(s.iAlive),
+             s.damage1Alive, s.damage2Alive, double(s.iDead), s.damage1Dead, s.damage2Dead };
+}
+
+std::vector<column> detailedStatsColumns(const herdStats &stats) {
+    const char *traits[5] = { "Gen1", "Gen2", "Gen3", "Damage1", "Damage2" };
+    std::vector<column> columns = { { "Generation", columnType::int32 } };
+    for (const char *t : traits) {
+        columns.push_back({ std::string(t) + "Mean", columnType::float64 });
+        columns.push_back({ std::string(t) + "Var", columnType::float64 });
+    }
+    for (int k = 0; k < 5; ++k)
+        for (size_t b = 0; b < (k < 3 ? stats.genHist[k] : stats.damageHist[k - 3]).size(); ++b)
+            columns.push_back({ std::string(traits[k]) + "Bin" + std::to_string(b), columnType::int32 });
+    return columns;
+}
+
+void detailedStatsRow(const herdStats &stats, const int &time, double *row) {
+    *row++ = time;
+    for (int k = 0; k < 3; ++k) {
+        *row++ = stats.genAlive[k].mean();
+        *row++ = stats.genAlive[k].variance();
+    }
+    for (int k = 0; k < 2; ++k) {
+        *row++ = stats.damageAlive[k].mean();
+        *row++ = stats.damageAlive[k].variance();
+    }
+    for (int k = 0; k < 5; ++k) {
+        const histogram &h = k < 3 ? stats.genHist[k] : stats.damageHist[k - 3];
+        for (size_t b = 0; b < h.size(); ++b)
+            *row++ = h[b];
+    }
+}
+
+void reproductionScratch::reserve(const size_t &popSize) {
+    offspring.reserve(popSize);
+    deadSheep.reserve(popSize);
+    uParent.reserve(popSize);
+    parentOf.reserve(popSize);
+    uMutate.reserve(3 * popSize);
+    zMutate.reserve(3 * popSize + 1);				// fillNormal rounds up to whole pairs
+}
+
+double offspringWeight(const double &gen1, const parameters &p) {
+    double tmp = 1 - gen1;								// Offspring resources
+    double dOffspring = (p.maxOffspring * tmp) / (p.alfa + tmp);
+    return dOffspring == 0 ? 0.0001 : dOffspring;
+}
+
+template<typename Storage>
+void reproduceSheep(basicHerd<Storage> &generation, const parameters &p, reproductionScratch &scratch, herdStats *stats) {
+    // Reproduce all sheep, then replace dead individuals with newborns
+    {
+        MILS_TIME(timer::parentSampling);
+        sampleParents(generation, p, scratch);
+    }
+    MILS_TIME(timer::mutation);
+    placeOffspring(generation, p, scratch, stats);
+}
+
+template<typename Storage>
+void sampleParents(basicHerd<Storage> &generation, const parameters &p, reproductionScratch &scratch) {
+    std::vector<double> &offspring = scratch.offspring;
+    std::vector<int> &deadSheep = scratch.deadSheep;
+    offspring.resize(generation.size());
+    deadSheep.clear();
+
+    for (size_t i = 0; i < generation.size(); ++i)		// Determine number of offspring for each individual
+        offspring[i] = offspringWeight(generation.gen1[i], p);
+
+    for (size_t i = 0; i < generation.size(); ++i) {	// Find dead sheep in generation, and store their position in the vector
+        if (!generation.alive[i])
+            deadSheep.push_back(i);
+    }
+
+    aliasTable &parents = scratch.parents;
+    parents.build(offspring);							// Build weighted lottery once per generation
+
+    std::vector<double> &uParent = scratch.uParent;
+    fillUniform(uParent, deadSheep.size());
+    scratch.parentOf.resize(deadSheep.size());
+    for (size_t j = 0; j < deadSheep.size(); ++j)
+        scratch.parentOf[j] = parents.draw(uParent[j]);	// Pick parent in O(1)
+}
+
+template<typename Storage>
+void placeOffspring(basicHerd<Storage> &generation, const parameters &p, reproductionScratch &scratch, herdStats *stats) {
+    const std::vector<int> &deadSheep = scratch.deadSheep;
+    std::vector<double> &uMutate = scratch.uMutate, &zMutate = scratch.zMutate;
+    fillUniform(uMutate, 3 * deadSheep.size());			// Pre-generate all variates for this generation's mutations
+    fillNormal(zMutate, 3 * deadSheep.size());
+
+    MILS_COUNT(counter::births, deadSheep.size());
+    for (size_t j = 0; j < deadSheep.size(); ++j) {		// Replace dead sheep with the (possibly mutated) offspring of their parent
+        generation.birth(deadSheep[j], scratch.parentOf[j], &uMutate[3 * j], &zMutate[3 * j], p);
+        if (stats)
+            stats->birth(generation.gen1[deadSheep[j]], generation.gen2[deadSheep[j]], generation.gen3[deadSheep[j]]);
+    }
+}
+
+template void reproduceSheep(herd&, const parameters&, reproductionScratch&, herdStats*);
+template void reproduceSheep(compactHerd&, const parameters&, reproductionScratch&, herdStats*);
+template void sampleParents(herd&, const parameters&, reproductionScratch&);
+template void sampleParents(compactHerd&, const parameters&, reproductionScratch&);
+template void placeOffspring(herd&, const parameters&, reproductionScratch&, herdStats*);
+template void placeOffspring(compactHerd&, const parameters&, reproductionScratch&, herdStats*);
+
+template<typename Herd>
+static void simulateHerd(const parameters &p, const std::string &fileName) {
+    // Run multiple generations, reproduction and mutations included
+
+    int iTime = 0;													// Nr of simulations to run
+
+    const std::string checkpointName = fileName + ".ckpt";
+    checkpointWriter checkpoints;
+    Herd vHerd;
+    std::vector<int64_t> resumeAt(p.detailedStats ? 3 : 2, -1);		// Output file sizes to continue from (-1 = start new files)
+    std::vector<uint64_t> chunkStates;								// Streams of the chunks or demes, when resuming a chunked or deme run
+
+    if (p.resume && std::filesystem::exists(checkpointName)) {		// Continue where the last checkpoint left off..
+        checkpoint c = readCheckpoint(checkpointName);
+        const bool sameLayout = c.chunkStates.empty() ? p.chunkSize == 0 && p.nDemes <= 1	// Chunk or deme streams fit only their own layout
+                                                      : c.chunkSize == p.chunkSize && c.nDemes == p.nDemes;
+        if (c.popSize != p.popSize || c.parameterHash != resumeHash(p) || c.outputSizes.size() != resumeAt.size() || !sameLayout)
+            throw std::runtime_error(checkpointName + " does not match the current parameters");
+        iTime = c.iTime;
+        if constexpr (std::is_same_v<Herd, herd>)
+            vHerd = std::move(c.vHerd);
+        else
+            vHerd = Herd(c.vHerd);									// Checkpoints hold doubles; converting back is exact
+        restoreRngState(c);
+        resumeAt.assign(c.outputSizes.begin(), c.outputSizes.end());
+        chunkStates = std::move(c.chunkStates);
+        std::cout << fileName + ": resuming at generation " + std::to_string(iTime) + "\n";
+    }
+    else if (!p.startPopulation.empty())
+        vHerd = Herd(initiatePopulation(p));						// .. or start from a saved population
+    else {
+        vHerd = Herd(p.popSize);									// .. or initialize a population of size 'popSize'
+        vHerd.initiate(p);
+    }
+
+    // Open output sinks
+    const columnType I = columnType::int32, D = columnType::float64;
+    std::unique_ptr<tableSink> multipleGenerations = openTable(p, "MGD_" + fileName,
+        { { "Generation", I }, { "NrAlive", I }, { "AgeAlive", D }, { "Gen1", D }, { "Gen2", D }, { "Gen 3", D }, { "Damage1", D }, { "Damage2", D },
+          { "Gen1Dead", D }, { "Gen2Dead", D }, { "Gen3Dead", D }, { "Damage1Dead", D }, { "Damage2Dead", D }, { "NrDead", I }, { "AgeDead", D } }, ",", resumeAt[0]);
+
+    std::unique_ptr<tableSink> individualData = openTable(p, "Individual_Data" + fileName,
+        { { "Generation", I }, { "Alive", I }, { "Age", I }, { "Damage1", D }, { "Damage2", D }, { "Gen1", D }, { "Gen2", D }, { "Gen 3", D }, { "DeathCause", I } }, ", ", resumeAt[1]);
+
+    herdStats stats(p);												// Kept up to date by the herd kernels; see herdstats.h
+    std::unique_ptr<tableSink> detailedStats;
+    std::vector<double> detailedRow;
+    if (p.detailedStats) {
+        detailedStats = openTable(p, "Stats_" + fileName, detailedStatsColumns(stats), ",", resumeAt[2]);
+        detailedRow.resize(detailedStatsColumns(stats).size());
+    }
+    const int statsInterval = std::max(p.statsInterval, 1);
+
+    std::unique_ptr<herdChunks> chunks;								// Parallel generation step; see herdchunks.h
+    std::unique_ptr<herdDemes> demes;								// Island model; see herddemes.h
+    if constexpr (std::is_same_v<Herd, herd>) {
+        if (p.nDemes > 1 && p.chunkSize > 0)
+            throw std::invalid_argument("Use either chunkSize or nDemes > 1; demes already run in parallel");
+        if (p.nDemes > 1)
+            demes = std::make_unique<herdDemes>(p, vHerd);
+        else if (p.chunkSize > 0)
+            chunks = std::make_unique<herdChunks>(p, vHerd);
+    }
+    if (chunks) {
+        if (chunkStates.empty())
+            chunks->seed();
+        else
+            chunks->setStates(chunkStates);
+    }
+    if (demes) {
+        if (chunkStates.empty())
+            demes->seed();
+        else
+            demes->setStates(chunkStates);
+    }
+
+    reproductionScratch scratch;									// Sized once; the generation loop below does not allocate
+    scratch.reserve(p.popSize);
+    char progress[256];
+    const int firstTime = iTime;
+    size_t steadyAllocations = 0;									// Heap allocations in generations without snapshots or checkpoints
+    int steadyGenerations = 0;
+    int windowStart = iTime;										// First generation of the current instrumentation window
+    if (instrumentationEnabled())
+        instrumentation::local().beginRun(fileName, !p.traceFile.empty());
+
+    do {
+        const size_t allocationsBefore = allocationCount();
+        const bool snapshot = iTime % snapshotInterval == 0;
+        const bool rebuild = iTime == firstTime || snapshot || (p.checkpointInterval > 0 && iTime % p.checkpointInterval == 0);
+        if (demes) {
+            {
+                MILS_TIME(timer::kill);		// Runs every deme ahead to the next generation whose herd is needed; see herddemes.h
+                demes->step(iTime, stats);
+            }
+            MILS_TIME(timer::statistics);
+            if (detailedStats && iTime % statsInterval == 0)
+                detailedStatsRow(stats, iTime, detailedRow.data());
+        }
+        else if (chunks) {
+            if (rebuild)
+                chunks->rebuildStats();
+            {
+                MILS_TIME(timer::kill);		// Damage, deaths and ageing of all chunks in one parallel stage
+                chunks->step(iTime % statsInterval == 0);
+            }
+            MILS_TIME(timer::statistics);
+            chunks->mergeStats(stats);
+            if (detailedStats && iTime % statsInterval == 0)
+                detailedStatsRow(stats, iTime, detailedRow.data());
+        }
+        else {
+            if (rebuild)
+                stats.rebuild(vHerd);		// Recount now and then, at generations that do not depend on where a resumed run started
+            {
+                MILS_TIME(timer::addDamage);
+                vHerd.addDamage(p);			// Add damage to sheep..
+            }
+            {
+                MILS_TIME(timer::kill);
+                stats.gatherDamage = iTime % statsInterval == 0;
+                vHerd.kill(p, &stats);		// .. and kill accordingly, updating the statistics
+            }
+            MILS_TIME(timer::statistics);
+            vHerd.advanceAge(&stats);		// If sheep survived, +1 to age
+            if (detailedStats && iTime % statsInterval == 0)
+                detailedStatsRow(stats, iTime, detailedRow.data());
+        }
+        if (iTime % statsInterval == 0) {	// Output statistics; all dead sheep died this generation
+            MILS_TIME(timer::output);
+            multipleGenerations->addRow({ double(iTime), double(stats.nAlive()), double(stats.ageAlive),									// Info on sheep alive
+                                          stats.genAlive[0].sum(), stats.genAlive[1].sum(), stats.genAlive[2].sum(), stats.damageAlive[0].sum(), stats.damageAlive[1].sum(),
+                                          stats.genDead[0].value(), stats.genDead[1].value(), stats.genDead[2].value(),					// Info on dead sheep
+                                          stats.damageDead[0].value(), stats.damageDead[1].value(), double(stats.nDead), double(stats.ageDead) });
+            if (detailedStats)
+                detailedStats->addRow(detailedRow.data());
+        }
+        // Store info on every sheep every snapshotInterval-th generation
+        if (snapshot) {
+            MILS_TIME(timer::output);
+            for (size_t i = 0; i < vHerd.size(); ++i) {
+                individualData->addRow({ double(iTime), double(vHerd.alive[i]), double(vHerd.age[i]), vHerd.damageTrait1[i], vHerd.damageTrait2[i],
+                                         vHerd.gen1[i], vHerd.gen2[i], vHerd.gen3[i], double(vHerd.deathCause[i]) });
+            }
+        }
+
+        if (demes)
+            demes->reproduce(iTime);
+        else if (chunks)
+            chunks->reproduce();
+        else
+            reproduceSheep(vHerd, p, scratch, &stats);		// Reproduce sheep to fill up place of dead individuals
+
+        ++iTime;
+        if (iTime % 50 == 0) {								// One write per line, so parallel replicates don't interleave
+            int n = std::snprintf(progress, sizeof(progress), "%s: simulating generation: %d\n", fileName.c_str(), iTime);
+            std::cout.write(progress, std::min<int>(n, sizeof(progress) - 1));
+        }
+
+        const bool checkpointDue = p.checkpointInterval > 0 && iTime % p.checkpointInterval == 0 && iTime < p.maxGens;
+        if (!snapshot && !checkpointDue && iTime - firstTime > 50) {	// Skip the first generations: buffers are still growing
+            steadyAllocations += allocationCount() - allocationsBefore;
+            ++steadyGenerations;
+        }
+
+        if (checkpointDue) {
+            MILS_TIME(timer::checkpoint);
+            multipleGenerations->flush();					// Output on disk must match the checkpoint
+            individualData->flush();
+            if (detailedStats)
+                detailedStats->flush();
+            checkpoint c;
+            c.iTime = iTime;
+            c.popSize = p.popSize;
+            c.parameterHash = resumeHash(p);
+            c.vHerd = herd(vHerd);							// Copy, in doubles; written to disk in the background
+            saveRngState(c);
+            if (chunks)
+                c.chunkStates = chunks->getStates();
+            else if (demes)
+                c.chunkStates = demes->getStates();
+            c.chunkSize = p.chunkSize;
+            c.nDemes = p.nDemes;
+            c.outputSizes = { multipleGenerations->bytesWritten(), individualData->bytesWritten() };
+            if (detailedStats)
+                c.outputSizes.push_back(detailedStats->bytesWritten());
+            checkpoints.save(checkpointName, std::move(c));
+        }
+
+        if (instrumentationEnabled() && (iTime - windowStart == std::max(p.instrumentWindow, 1) || iTime == p.maxGens)) {
+            instrumentation::local().closeWindow(windowStart, iTime - 1);
+            windowStart = iTime;
+        }
+
+        if (iTime == p.maxGens && p.savePopulation) {			// For warm starts of later runs (startPopulation)
+            MILS_TIME(timer::checkpoint);
+            checkpoint c;
+            c.iTime = iTime;
+            c.popSize = p.popSize;
+            c.vHerd = herd(vHerd);
+            writeCheckpoint(fileName + ".pop", c);
+        }
+
+        if (iTime == p.maxGens) {								// Let last generation continue until all are dead.
+            std::cout << fileName + ": simulating last generation\n";
+            iterate(p, "LastGen" + fileName, NULL, herd(std::move(vHerd)));  // Nasty; the herd is not used after this. Compact herds run it in doubles
+        }
+    } while (iTime < p.maxGens);
+
+    multipleGenerations->close();
+    individualData->close();
+    if (detailedStats)
+        detailedStats->close();
+    checkpoints.wait();
+    std::filesystem::remove(checkpointName);				// Finished; a later resume starts over
+
+    if (instrumentationEnabled())
+        instrumentation::local().endRun();
+    if (allocationCountingEnabled()) {
+        std::cout << fileName + ": " + std::to_string(steadyAllocations) + " heap allocations in " + std::to_string(steadyGenerations) + " steady-state generations\n";
+        if (steadyAllocations > 0)								// Fails the run, so a regression can't go unnoticed
+            throw std::runtime_error(fileName + ": the generation loop allocated " + std::to_string(steadyAllocations) + " times in steady state");
+    }
+}
+
+void simulate(const parameters &p, const std::string &fileName) {
+    if (p.storage == "compact") {
+        if (p.chunkSize > 0 || p.nDemes > 1)
+            throw std::invalid_argument("chunkSize and nDemes need storage = double");
+        simulateHerd<compactHerd>(p, fileName);
+    }
+    else if (p.storage == "double")
+        simulateHerd<herd>(p, fileName);
+    else
+        throw std::invalid_argument("Unknown storage: " + p.storage + " (use double or compact)");
+}
+
+void runReplicates(const parameters &p, const unsigned int &masterSeed) {
+    // Spread replicates over a pool of worker threads. Replicate i always runs with replicateSeed(masterSeed, i),
+    // so every output file is reproducible regardless of the number of threads or the order they finish in.
+
+    threadPool pool(std::min(p.nThreads ? p.nThreads : std::thread::hardware_concurrency(), static_cast<unsigned int>(std::max(p.nReplicates, 1))));
+    for (int i = 0; i < p.nReplicates; ++i) {
+        pool.submit([&p, masterSeed, i]() {
+            seedRng(replicateSeed(masterSeed, i), p.bulkGenerator);	// Fresh, independent stream for this replicate
+            simulate(p, p.outputName + std::to_string(i));
+        });
+    }
+    pool.wait();
+}
@@ -0,0 +1,59 @@
+#ifndef MILS_SIMULATION_H
+#define MILS_SIMULATION_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <array>
+#include <iostream>
+#include "parameters.h"
+#include "herd.h"
+#include "herdstats.h"
+#include "output.h"
+
+const int snapshotInterval = 5000;				// Generations between the Individual_Data rows of every sheep
+
+// Statistics of one timestep of a single cohort (see runCohort)
+struct cohortStats {
+    int time;
+    double gen1Total, gen2Total, gen3Total;		// Summed genes of the survivors
+    int iAlive;
+    double damage1Alive, damage2Alive;			// Summed damage of the survivors
+    int iDead;									// Died during this timestep
+    double damage1Dead, damage2Dead;			// Summed damage of those that died during this timestep
+};
+
+// Buffers reused by reproduceSheep from one generation to the next, so that a generation does no heap allocations
+struct reproductionScratch {
+    void reserve(const size_t &popSize);		// Size everything for the worst case of the whole herd dying
+
+    std::vector<double> offspring;				// Offspring weight per individual
+    std::vector<int> deadSheep;					// Slots to fill with newborns
+    aliasTable parents;
+    std::vector<int> parentOf;					// Parent drawn for each slot in deadSheep
+    std::vector<double> uParent;				// Pre-generated variates for the births
+    std::vector<double> uMutate;
+    std::vector<double> zMutate;
+};
+
+//Function declaration:
+
+herd initiatePopulation(const parameters &p);																				// Initiate population of size 'p.popSize', or load p.startPopulation
+void runCohort(const parameters &p, herd vHerd, const std::function<void(const cohortStats&)> &onTimestep);					// Run a single cohort until all sheep are dead, reporting every timestep
+void iterate(const parameters &p, std::string outputFileName = "", double parameter = NULL, herd vHerd = herd());			// Run a single cohort until all sheep are dead and write it to an output table. No reproduction
+std::vector<column> cohortColumns();																							// Columns / one row of iterate's output table
+std::array<double, 10> cohortRow(const cohortStats &s);
+std::vector<column> detailedStatsColumns(const herdStats &stats);																// Columns / one row of the Stats_ output:
+void detailedStatsRow(const herdStats &stats, const int &time, double *row);													// mean and variance of every trait, then the histograms
+double offspringWeight(const double &gen1, const parameters &p);																// Relative number of offspring of an individual with gene 1 'gen1'
+template<typename Storage>
+void reproduceSheep(basicHerd<Storage> &generation, const parameters &p, reproductionScratch &scratch, herdStats *stats = nullptr);	// Allow sheep to reproduce, registering the births in 'stats':
+template<typename Storage>
+void sampleParents(basicHerd<Storage> &generation, const parameters &p, reproductionScratch &scratch);								// 1. find the dead and draw a parent for each
+template<typename Storage>
+void placeOffspring(basicHerd<Storage> &generation, const parameters &p, reproductionScratch &scratch, herdStats *stats = nullptr);	// 2. replace them by mutated offspring
+void simulate(const parameters &p, const std::string &fileName);																// Run multiple generations of sheep. reproduction and mutations allowed,
+                                                                                                                                // in the column types selected by p.storage
+void runReplicates(const parameters &p, const unsigned int &masterSeed);														// Run replicate simulations in parallel, each with its own seeded engine
+
+#endif //MILS_SIMULATION_H
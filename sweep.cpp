@@ -0,0 +1,166 @@
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include "sweep.h"
+#include "simulation.h"
+#include "threadpool.h"
+#include "output.h"
+#include "randomnumbers.h"
+
+std::vector<sweepDimension> parseSweep(const std::string &spec) {
+    std::vector<sweepDimension> dims;
+    std::istringstream all(spec);
+    std::string item;
+    while (std::getline(all, item, ',')) {
+        std::istringstream is(item);
+        sweepDimension d;
+        std::string first, last, n = "1";
+        if (!std::getline(is, d.name, ':') || !std::getline(is, first, ':') || !std::getline(is, last, ':'))
+            throw std::invalid_argument("Bad sweep dimension '" + item + "', expected name:first:last[:n]");
+        std::getline(is, n);
+        try {
+            size_t end;
+            d.first = std::stod(first, &end);
+            if (end != first.size())							// Trailing garbage, as in 0.1abc
+                throw std::invalid_argument(first);
+            d.last = std::stod(last, &end);
+            if (end != last.size())
+                throw std::invalid_argument(last);
+            d.n = std::stoi(n, &end);
+            if (end != n.size())
+                throw std::invalid_argument(n);
+        }
+        catch (const std::logic_error &) {						// invalid_argument and out_of_range
+            throw std::invalid_argument("Bad sweep dimension '" + item + "', expected name:first:last[:n] with numbers first, last and n");
+        }
+        if (d.n < 1)
+            throw std::invalid_argument("Sweep dimension " + d.name + " needs at least 1 point");
+
+        const parameterKind kind = kindOf(d.name);				// Reject unknown or non-numeric parameters before any work is done
+        if (kind == parameterKind::text)
+            throw std::invalid_argument("Cannot sweep " + d.name + ": not a numeric parameter");
+        d.integer = kind == parameterKind::integer;
+        dims.push_back(d);
+    }
+    if (dims.empty())
+        throw std::invalid_argument("Empty sweep specification");
+    return dims;
+}
+
+static double gridValue(const sweepDimension &d, const int &k) {
+    return d.n == 1 ? d.first : d.first + (d.last - d.first) * k / (d.n - 1);
+}
+
+std::vector<std::vector<double>> gridDesign(const std::vector<sweepDimension> &dims) {
+    size_t nPoints = 1;
+    for (const sweepDimension &d : dims)
+        nPoints *= d.n;
+
+    std::vector<std::vector<double>> design(nPoints, std::vector<double>(dims.size()));
+    for (size_t i = 0; i < nPoints; ++i) {
+        size_t rest = i;
+        for (size_t j = dims.size(); j-- > 0;) {				// Mixed-radix decomposition of the point index
+            design[i][j] = gridValue(dims[j], static_cast<int>(rest % dims[j].n));
+            rest /= dims[j].n;
+        }
+    }
+    return design;
+}
+
+std::vector<std::vector<double>> latinHypercube(const std::vector<sweepDimension> &dims, const int &nPoints, const unsigned int &seed) {
+    std::mt19937 engine(seed);									// Own engine: the design depends on the seed only
+    std::uniform_real_distribution<> u{};
+    std::vector<std::vector<double>> design(nPoints, std::vector<double>(dims.size()));
+
+    std::vector<int> strata(nPoints);
+    for (size_t j = 0; j < dims.size(); ++j) {
+        for (int k = 0; k < nPoints; ++k)
+            strata[k] = k;
+        std::shuffle(strata.begin(), strata.end(), engine);	// Each of the nPoints strata used exactly once per dimension
+        for (int i = 0; i < nPoints; ++i) {
+            double x = (strata[i] + u(engine)) / nPoints;
+            design[i][j] = dims[j].first + (dims[j].last - dims[j].first) * x;
+        }
+    }
+    return design;
+}
+
+static void setPoint(parameters &p, const std::vector<sweepDimension> &dims, const std::vector<double> &point) {
+    for (size_t j = 0; j < dims.size(); ++j) {
+        std::ostringstream value;
+        value.precision(17);
+        value << point[j];
+        setParameter(p, dims[j].name, value.str());
+    }
+}
+
+std::vector<std::vector<double>> sweepDesign(const parameters &p, const std::vector<sweepDimension> &dims, const unsigned int &masterSeed) {
+    std::vector<std::vector<double>> design;
+    if (p.sweepDesign == "grid")
+        design = gridDesign(dims);
+    else if (p.sweepDesign == "lhs")
+        design = latinHypercube(dims, p.sweepPoints, replicateSeed(masterSeed, -1));
+    else
+        throw std::invalid_argument("Unknown sweepDesign: " + p.sweepDesign + " (grid or lhs)");
+
+    parameters check = p;
+    for (std::vector<double> &point : design) {
+        for (size_t j = 0; j < dims.size(); ++j)
+            if (dims[j].integer)
+                point[j] = std::round(point[j]);				// The value the point runs with, and is written out with
+        setPoint(check, dims, point);
+    }
+    return design;
+}
+
+std::vector<cohortStats> runSweepPoint(const parameters &p, const std::vector<sweepDimension> &dims, const std::vector<double> &point, const unsigned int &seed) {
+    parameters atPoint = p;
+    setPoint(atPoint, dims, point);
+    seedRng(seed, atPoint.bulkGenerator);
+    std::vector<cohortStats> result;
+    runCohort(atPoint, herd(), [&](const cohortStats &s) { result.push_back(s); });
+    return result;
+}
+
+void writeSweep(const parameters &p, const std::vector<sweepDimension> &dims, const std::vector<std::vector<double>> &design,
+                const std::vector<std::vector<cohortStats>> &results) {
+    std::vector<column> columns = { { "Point", columnType::int32 } };
+    for (const sweepDimension &d : dims)
+        columns.push_back({ d.name, columnType::float64 });
+    for (const column &c : cohortColumns())
+        columns.push_back(c);
+
+    std::unique_ptr<tableSink> table = openTable(p, "Sweep_" + p.outputName, columns, ", ");
+    std::vector<double> row;
+    for (size_t i = 0; i < design.size(); ++i) {
+        for (const cohortStats &s : results[i]) {
+            row.assign(1, double(i));
+            row.insert(row.end(), design[i].begin(), design[i].end());
+            std::array<double, 10> stats = cohortRow(s);
+            row.insert(row.end(), stats.begin(), stats.end());
+            table->addRow(row.data());
+        }
+    }
+    table->close();												// Here, not on destruction, so a failed write is reported
+}
+
+void runSweep(const parameters &p, const unsigned int &masterSeed) {
+    std::vector<sweepDimension> dims = parseSweep(p.sweep);
+    std::vector<std::vector<double>> design = sweepDesign(p, dims, masterSeed);
+
+    std::vector<std::vector<cohortStats>> results(design.size());	// One slot per point, so no locking is needed
+    {
+        threadPool pool(p.nThreads);
+        for (size_t i = 0; i < design.size(); ++i) {
+            pool.submit([&, i]() {
+                results[i] = runSweepPoint(p, dims, design[i], replicateSeed(masterSeed, static_cast<int>(i)));
+                std::cout << "Sweep point " + std::to_string(i + 1) + "/" + std::to_string(design.size()) + " done\n";
+            });
+        }
+        pool.wait();
+    }
+    writeSweep(p, dims, design, results);
+}
@@ -0,0 +1,42 @@
+#ifndef MILS_SWEEP_H
+#define MILS_SWEEP_H
+
+#include <string>
+#include <vector>
+#include "parameters.h"
+#include "simulation.h"
+
+// One swept parameter: 'name' runs from 'first' to 'last' (inclusive) in 'n' points
+struct sweepDimension {
+    std::string name;
+    double first;
+    double last;
+    int n;
+    bool integer;		// An integer parameter: design values are rounded to whole numbers
+};
+
+// Parse "name:first:last:n,name:first:last:n,..."; names must be numeric parameters. n defaults to 1 (for lhs designs)
+std::vector<sweepDimension> parseSweep(const std::string &spec);
+
+// Full factorial grid over all dimensions; the last dimension varies fastest
+std::vector<std::vector<double>> gridDesign(const std::vector<sweepDimension> &dims);
+
+// Latin hypercube of nPoints points over the [first, last] ranges (dimension n is ignored)
+std::vector<std::vector<double>> latinHypercube(const std::vector<sweepDimension> &dims, const int &nPoints, const unsigned int &seed);
+
+// Design points of p.sweep as set by p.sweepDesign; an lhs design is drawn with replicateSeed(masterSeed, -1).
+// Values of integer parameters are rounded, and every point is checked, so a bad value fails before any point runs.
+std::vector<std::vector<double>> sweepDesign(const parameters &p, const std::vector<sweepDimension> &dims, const unsigned int &masterSeed);
+
+// Run the single cohort of one design point, with the swept parameters set to 'point' and the engines seeded with 'seed'
+std::vector<cohortStats> runSweepPoint(const parameters &p, const std::vector<sweepDimension> &dims, const std::vector<double> &point, const unsigned int &seed);
+
+// Write the cohorts of all points, in point order, to "Sweep_<outputName>"
+void writeSweep(const parameters &p, const std::vector<sweepDimension> &dims, const std::vector<std::vector<double>> &design,
+                const std::vector<std::vector<cohortStats>> &results);
+
+// Run one single cohort (as iterate) for every design point on a work-stealing pool, and write all of them to
+// "Sweep_<outputName>" (.csv or .mcol) with a column per swept parameter. Point i runs with replicateSeed(masterSeed, i).
+void runSweep(const parameters &p, const unsigned int &masterSeed);
+
+#endif //MILS_SWEEP_H
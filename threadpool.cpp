@@ -0,0 +1,113 @@
+#include <algorithm>
+#include "threadpool.h"
+
+threadPool::threadPool(unsigned int nThreads) {
+    if (nThreads == 0)
+        nThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int i = 0; i < nThreads; ++i)
+        queues.push_back(std::make_unique<taskQueue>());
+    for (unsigned int i = 0; i < nThreads; ++i)
+        workers.emplace_back(&threadPool::run, this, i);
+}
+
+threadPool::~threadPool() {
+    {
+        std::unique_lock<std::mutex> lock(m);
+        allDone.wait(lock, [this] { return pending == 0; });
+        stop = true;
+    }
+    workAvailable.notify_all();
+    for (auto &worker : workers)
+        worker.join();
+}
+
+void threadPool::submit(std::function<void()> task) {
+    unsigned int q = nextQueue++ % queues.size();
+    ++pending;
+    {
+        std::lock_guard<std::mutex> lock(queues[q]->m);
+        queues[q]->pushBack(task);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m);			// Under the lock, so a worker going to sleep can't miss it
+        ++queued;
+    }
+    workAvailable.notify_one();
+}
+
+void threadPool::wait() {
+    std::unique_lock<std::mutex> lock(m);
+    allDone.wait(lock, [this] { return pending == 0; });
+    if (firstError) {
+        std::exception_ptr error = firstError;
+        firstError = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void threadPool::taskQueue::pushBack(std::function<void()> &task) {
+    if (count == ring.size()) {							// Full: move the tasks in order into a ring twice the size
+        std::vector<std::function<void()>> bigger(2 * ring.size());
+        for (size_t i = 0; i < count; ++i)
+            bigger[i] = std::move(ring[(head + i) % ring.size()]);
+        ring.swap(bigger);
+        head = 0;
+    }
+    ring[(head + count) % ring.size()] = std::move(task);
+    ++count;
+}
+
+void threadPool::taskQueue::popBack(std::function<void()> &task) {
+    --count;
+    task = std::move(ring[(head + count) % ring.size()]);
+    ring[(head + count) % ring.size()] = nullptr;
+}
+
+void threadPool::taskQueue::popFront(std::function<void()> &task) {
+    task = std::move(ring[head]);
+    ring[head] = nullptr;
+    head = (head + 1) % ring.size();
+    --count;
+}
+
+bool threadPool::tryPop(const unsigned int &id, std::function<void()> &task) {
+    const size_t n = queues.size();
+    for (size_t k = 0; k < n; ++k) {					// Own queue first (k == 0), then steal from the others
+        taskQueue &q = *queues[(id + k) % n];
+        std::lock_guard<std::mutex> lock(q.m);
+        if (q.count == 0)
+            continue;
+        if (k == 0)
+            q.popBack(task);
+        else
+            q.popFront(task);
+        --queued;
+        return true;
+    }
+    return false;
+}
+
+void threadPool::run(const unsigned int &id) {
+    std::function<void()> task;
+    while (true) {
+        if (tryPop(id, task)) {
+            try {
+                task();
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(m);
+                if (!firstError)
+                    firstError = std::current_exception();
+            }
+            task = nullptr;
+            std::lock_guard<std::mutex> lock(m);
+            if (--pending == 0)
+                allDone.notify_all();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m);
+        workAvailable.wait(lock, [this] { return stop || queued > 0; });
+        if (stop && queued == 0)
+            return;
+    }
+}
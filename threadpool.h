@@ -0,0 +1,54 @@
+#ifndef MILS_THREADPOOL_H
+#define MILS_THREADPOOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <exception>
+
+//Class def:
+// Work-stealing thread pool. Every worker has its own task queue; submitted tasks are dealt out round-robin,
+// a worker takes from the back of its own queue and steals from the front of the others when it runs dry.
+// The queues are rings that only grow when full, so once they have held the largest batch, submitting a task
+// whose callable fits in std::function (as the chunk and deme tasks do) does not allocate.
+class threadPool {
+public:
+    explicit threadPool(unsigned int nThreads = 0);		// 0 = one worker per hardware thread
+    ~threadPool();										// Finishes all submitted tasks, then joins the workers
+
+    void submit(std::function<void()> task);
+    void wait();										// Block until all submitted tasks are done; rethrows the first exception a task threw
+    unsigned int size() const { return static_cast<unsigned int>(workers.size()); }
+
+private:
+    struct taskQueue {
+        std::mutex m;
+        std::vector<std::function<void()>> ring = std::vector<std::function<void()>>(64);	// Tasks at ring[(head + i) % ring.size()], i < count
+        size_t head = 0;
+        size_t count = 0;
+
+        void pushBack(std::function<void()> &task);
+        void popBack(std::function<void()> &task);
+        void popFront(std::function<void()> &task);
+    };
+
+    void run(const unsigned int &id);					// Worker loop
+    bool tryPop(const unsigned int &id, std::function<void()> &task);
+
+    std::vector<std::unique_ptr<taskQueue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex m;										// Guards the sleep/wake state below
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    std::atomic<size_t> queued{ 0 };					// Tasks waiting in a queue
+    std::atomic<size_t> pending{ 0 };					// Tasks submitted but not finished
+    std::atomic<unsigned int> nextQueue{ 0 };
+    bool stop = false;
+    std::exception_ptr firstError = nullptr;
+};
+
+#endif //MILS_THREADPOOL_H
@@ -0,0 +1,168 @@
+// Accuracy report for compact storage (storage = compact): runs the same replicates in double and in compact storage and
+// compares what a study would look at, so the memory/accuracy trade-off can be judged per parameter set:
+// - the mean of gen 1-3 over the generations (largest difference of the replicate means, and that difference as a
+//   Welch t statistic over the replicates);
+// - the survival curve of the evolved population, run on as one cohort without reproduction (largest difference in
+//   the fraction alive);
+// - the first generation at which a replicate's path differs at all, and the memory per individual of both modes.
+// Both modes start from the same population with the same random numbers, so they agree until float rounding first
+// flips a death or a parent draw; after that they are independent realisations of the same model.
+//
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -pthread -I. tools/compact_accuracy.cpp allocations.cpp asyncsink.cpp checkpoint.cpp cohortevents.cpp herd.cpp
+//         herdchunks.cpp herddemes.cpp herdstats.cpp instrumentation.cpp output.cpp parameters.cpp randomnumbers.cpp sheep.cpp simulation.cpp threadpool.cpp
+//         -o compact_accuracy
+// Usage:
+//     ./compact_accuracy [replicates=N] [generations=N] [interval=N] [key=value ...]	(key=value sets model parameters)
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include "parameters.h"
+#include "randomnumbers.h"
+#include "herd.h"
+#include "herdstats.h"
+#include "simulation.h"
+
+struct trajectory {
+    std::vector<double> gen[3];				// Mean gene of the living, every 'interval' generations
+    std::vector<double> survival;			// Fraction of the final population alive, per timestep of the cohort
+    double bytesPerIndividual = 0;
+};
+
+template<typename Herd>
+trajectory run(const parameters &p, const unsigned int &seed, const int &generations, const int &interval) {
+    seedRng(seed, p.bulkGenerator);
+    Herd h(p.popSize);
+    h.initiate(p);
+    herdStats stats(p);
+    stats.rebuild(h);
+    reproductionScratch scratch;
+    scratch.reserve(p.popSize);
+
+    trajectory t;
+    for (int g = 0; g < generations; ++g) {
+        h.addDamage(p);
+        stats.gatherDamage = false;
+        h.kill(p, &stats);
+        h.advanceAge(&stats);
+        if (g % interval == 0)
+            for (int k = 0; k < 3; ++k)
+                t.gen[k].push_back(stats.genAlive[k].mean());
+        reproduceSheep(h, p, scratch, &stats);
+    }
+    t.bytesPerIndividual = double(h.memoryBytes()) / h.size();
+
+    const double n0 = double(stats.nAlive());
+    for (int time = 0; stats.nAlive() > 0 && time < p.maxGens; ++time) {
+        h.addDamage(p);
+        h.kill(p, &stats);
+        h.advanceAge(&stats);
+        t.survival.push_back(stats.nAlive() / n0);
+    }
+    return t;
+}
+
+// Mean and variance over the replicates of element i of every series; missing elements count as 'missing'
+void moments(const std::vector<const std::vector<double>*> &series, const size_t &i, const double &missing, double &mean, double &var) {
+    mean = var = 0;
+    for (const std::vector<double> *s : series)
+        mean += i < s->size() ? (*s)[i] : missing;
+    mean /= series.size();
+    for (const std::vector<double> *s : series) {
+        double d = (i < s->size() ? (*s)[i] : missing) - mean;
+        var += d * d;
+    }
+    var = series.size() > 1 ? var / (series.size() - 1) : 0;
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        parameters p;
+        p.popSize = 2000;
+        int replicates = 10, generations = 2000, interval = 50;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            size_t eq = arg.find('=');
+            if (eq == std::string::npos)
+                throw std::invalid_argument("Expected key=value, got: " + arg);
+            std::string key = arg.substr(0, eq), value = arg.substr(eq + 1);
+            if (key == "replicates")
+                replicates = std::stoi(value);
+            else if (key == "generations")
+                generations = std::stoi(value);
+            else if (key == "interval")
+                interval = std::max(std::stoi(value), 1);
+            else
+                setParameter(p, key, value);
+        }
+
+        std::vector<trajectory> full, compact;
+        for (int rep = 0; rep < replicates; ++rep) {
+            full.push_back(run<herd>(p, replicateSeed(p.fixedSeed, rep), generations, interval));
+            compact.push_back(run<compactHerd>(p, replicateSeed(p.fixedSeed, rep), generations, interval));
+        }
+
+        std::cout << "Compact vs double storage: " << replicates << " replicates of " << generations << " generations, popSize " << p.popSize << "\n";
+        std::cout << "Memory per individual: double " << full[0].bytesPerIndividual << " bytes, compact " << compact[0].bytesPerIndividual
+                  << " bytes (compact includes its kill scratch of at most " << compactStorage::killBlock * 3 * sizeof(double) / 1024 << " KiB per herd)\n";
+
+        for (int rep = 0; rep < replicates; ++rep) {			// Where float rounding first changed the path
+            size_t g = 0;
+            while (g < full[rep].gen[0].size() && std::fabs(full[rep].gen[0][g] - compact[rep].gen[0][g]) <= 1e-6 * std::fabs(full[rep].gen[0][g]))
+                ++g;
+            std::cout << "Replicate " << rep << ": paths agree up to generation " << g * interval
+                      << (g == full[rep].gen[0].size() ? " (the end)" : "") << "\n";
+        }
+
+        for (int k = 0; k < 3; ++k) {
+            std::vector<const std::vector<double>*> a, b;
+            for (int rep = 0; rep < replicates; ++rep) {
+                a.push_back(&full[rep].gen[k]);
+                b.push_back(&compact[rep].gen[k]);
+            }
+            double maxDiff = 0, maxT = 0;
+            int worst = 0;
+            for (size_t i = 0; i < a[0]->size(); ++i) {
+                double mA, vA, mB, vB;
+                moments(a, i, 0, mA, vA);
+                moments(b, i, 0, mB, vB);
+                double se = std::sqrt((vA + vB) / replicates);
+                double t = se > 0 ? std::fabs(mA - mB) / se : 0;
+                if (std::fabs(mA - mB) > maxDiff) {
+                    maxDiff = std::fabs(mA - mB);
+                    worst = static_cast<int>(i) * interval;
+                }
+                maxT = std::max(maxT, t);
+            }
+            std::cout << "Mean gen " << k + 1 << ": largest difference " << maxDiff << " (generation " << worst << "), largest |t| " << maxT << "\n";
+        }
+
+        std::vector<const std::vector<double>*> a, b;
+        size_t length = 0;
+        for (int rep = 0; rep < replicates; ++rep) {
+            a.push_back(&full[rep].survival);
+            b.push_back(&compact[rep].survival);
+            length = std::max({ length, full[rep].survival.size(), compact[rep].survival.size() });
+        }
+        double maxDiff = 0;
+        size_t worst = 0;
+        for (size_t i = 0; i < length; ++i) {
+            double mA, vA, mB, vB;
+            moments(a, i, 0, mA, vA);
+            moments(b, i, 0, mB, vB);
+            if (std::fabs(mA - mB) > maxDiff) {
+                maxDiff = std::fabs(mA - mB);
+                worst = i;
+            }
+        }
+        std::cout << "Survival curve of the final population: largest difference in fraction alive " << maxDiff << " (timestep " << worst << ")" << std::endl;
+        return 0;
+    }
+    catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,56 @@
+// Convert a binary columnar output file (.mcol, written with outputFormat = binary) to CSV.
+//
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -pthread -I. tools/mcol2csv.cpp output.cpp asyncsink.cpp parameters.cpp randomnumbers.cpp -o mcol2csv
+// Usage:
+//     mcol2csv <input.mcol> [output.csv]		(writes to stdout without an output file)
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <exception>
+#include "output.h"
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || argc > 3) {
+        std::cerr << "Usage: " << argv[0] << " <input.mcol> [output.csv]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try {
+        columnarReader reader(argv[1]);
+        std::ofstream ofs;
+        if (argc == 3) {
+            ofs.open(argv[2]);
+            if (!ofs.is_open())
+                throw std::runtime_error(std::string("Cannot open ") + argv[2]);
+        }
+        std::ostream &os = argc == 3 ? ofs : std::cout;
+
+        const std::vector<column> &columns = reader.getColumns();
+        for (size_t c = 0; c < columns.size(); ++c)
+            os << (c ? "," : "") << columns[c].name;
+        os << '\n';
+
+        char field[32];
+        while (reader.nextChunk()) {
+            for (size_t i = 0; i < reader.rows(); ++i) {
+                for (size_t c = 0; c < columns.size(); ++c) {
+                    if (columns[c].type == columnType::int32)
+                        std::snprintf(field, sizeof(field), "%lld", static_cast<long long>(reader.values(c)[i]));
+                    else
+                        std::snprintf(field, sizeof(field), "%.17g", reader.values(c)[i]);	// Full precision
+                    os << (c ? "," : "") << field;
+                }
+                os << '\n';
+            }
+        }
+        if (!reader.complete())
+            std::cerr << "Warning: " << argv[1] << " has no end marker; the run may not have finished writing it" << std::endl;
+    }
+
+    catch (std::exception &error) {
+        std::cerr << error.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,215 @@
+// Query the output tables of a run (CSV or .mcol) without loading them: the file is memory-mapped and streamed one block
+// at a time, so this works on Individual_Data files far larger than memory. Results are written to stdout as CSV.
+//
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I. tools/milsquery.cpp outputreader.cpp -o milsquery
+// Usage:
+//     milsquery columns <file>
+//     milsquery stats <file> <column> [--where <expr>]... [--by <column>]
+//     milsquery histogram <file> <column> --bins <n> --lo <x> --hi <y> [--where <expr>]... [--by <column>]
+//     milsquery rows <file> [--where <expr>]... [--columns <a,b,...>]
+// Filters are "<column> <op> <value>" or "<column> % <m> <op> <value>" (see rowFilter in outputreader.h); all must pass.
+// Examples:
+//     milsquery stats Individual_Data_1.csv Gen2 --where "Alive == 1" --where "Generation % 5000 == 0" --by Generation
+//     milsquery histogram Individual_Data_1.csv Age --bins 50 --lo 0 --hi 50 --where "Alive == 0" --by DeathCause
+//     milsquery rows MGD_1.mcol --where "Generation % 100 == 0"			(decimate to every 100th generation)
+
+#include <iostream>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <exception>
+#include "outputreader.h"
+#include "herdstats.h"
+
+namespace {
+    struct query {
+        std::string command, fileName, column;
+        std::vector<std::string> filters;
+        std::string by;
+        std::string columns;
+        size_t bins = 0;
+        double lo = 0, hi = 0;
+        bool haveLo = false, haveHi = false;
+    };
+
+    struct group {
+        runningMoments moments;
+        double min = std::numeric_limits<double>::infinity();
+        double max = -std::numeric_limits<double>::infinity();
+        histogram counts;
+    };
+
+    void usage(const char *name) {
+        std::cerr << "Usage: " << name << " columns <file>\n"
+                  << "       " << name << " stats <file> <column> [--where <expr>]... [--by <column>]\n"
+                  << "       " << name << " histogram <file> <column> --bins <n> --lo <x> --hi <y> [--where <expr>]... [--by <column>]\n"
+                  << "       " << name << " rows <file> [--where <expr>]... [--columns <a,b,...>]" << std::endl;
+    }
+
+    query parseArguments(int argc, char *argv[]) {
+        query q;
+        if (argc < 3)
+            throw std::invalid_argument("Missing command or file");
+        q.command = argv[1];
+        q.fileName = argv[2];
+        int i = 3;
+        if (q.command == "stats" || q.command == "histogram") {
+            if (argc < 4)
+                throw std::invalid_argument("Missing column for " + q.command);
+            q.column = argv[i++];
+        }
+        for (; i < argc; ++i) {
+            const std::string option = argv[i];
+            if (i + 1 >= argc)
+                throw std::invalid_argument("Missing value for " + option);
+            const std::string value = argv[++i];
+            if (option == "--where")
+                q.filters.push_back(value);
+            else if (option == "--by")
+                q.by = value;
+            else if (option == "--columns")
+                q.columns = value;
+            else if (option == "--bins")
+                q.bins = std::stoul(value);
+            else if (option == "--lo") {
+                q.lo = std::stod(value);
+                q.haveLo = true;
+            }
+            else if (option == "--hi") {
+                q.hi = std::stod(value);
+                q.haveHi = true;
+            }
+            else
+                throw std::invalid_argument("Unknown option " + option);
+        }
+        if (q.command == "histogram" && (q.bins == 0 || !q.haveLo || !q.haveHi || q.hi <= q.lo))
+            throw std::invalid_argument("histogram needs --bins > 0 and --lo < --hi");
+        return q;
+    }
+
+    std::string number(const double &x) {
+        char field[32];
+        std::snprintf(field, sizeof(field), "%.17g", x);
+        return field;
+    }
+
+    bool passes(const std::vector<rowFilter> &filters, const size_t &row) {
+        for (const rowFilter &f : filters)
+            if (!f.test(row))
+                return false;
+        return true;
+    }
+
+    // stats and histogram: one pass, one group per distinct value of the --by column (a single group without it)
+    void aggregate(const query &q, tableReader &table, const std::vector<rowFilter> &filters) {
+        const size_t col = table.columnIndex(q.column);
+        const bool grouped = !q.by.empty();
+        const size_t byCol = grouped ? table.columnIndex(q.by) : 0;
+        std::map<double, group> groups;
+        while (table.nextBlock()) {
+            const double *x = table.values(col);
+            const double *key = grouped ? table.values(byCol) : nullptr;
+            for (size_t i = 0; i < table.rows(); ++i) {
+                if (!passes(filters, i))
+                    continue;
+                auto it = groups.find(grouped ? key[i] : 0.0);
+                if (it == groups.end())
+                    it = groups.emplace(grouped ? key[i] : 0.0, group{ {}, std::numeric_limits<double>::infinity(),
+                                        -std::numeric_limits<double>::infinity(), histogram(q.bins, q.lo, q.hi) }).first;
+                group &g = it->second;
+                g.moments.add(x[i]);
+                g.min = std::min(g.min, x[i]);
+                g.max = std::max(g.max, x[i]);
+                g.counts.add(x[i]);
+            }
+        }
+
+        const std::string byHeader = grouped ? table.getColumns()[byCol].name + "," : "";
+        if (q.command == "stats") {
+            std::cout << byHeader << "Count,Mean,SD,Min,Max\n";
+            for (const auto &kv : groups) {
+                const group &g = kv.second;
+                std::cout << (grouped ? number(kv.first) + "," : "") << g.moments.count() << "," << number(g.moments.mean()) << ","
+                          << number(std::sqrt(g.moments.variance())) << "," << number(g.min) << "," << number(g.max) << "\n";
+            }
+        }
+        else {
+            std::cout << byHeader << "BinLow,BinHigh,Count\n";			// The first and last bin also hold the values beyond them
+            const double width = (q.hi - q.lo) / q.bins;
+            for (const auto &kv : groups)
+                for (size_t b = 0; b < q.bins; ++b)
+                    std::cout << (grouped ? number(kv.first) + "," : "") << number(q.lo + b * width) << ","
+                              << number(q.lo + (b + 1) * width) << "," << kv.second.counts[b] << "\n";
+        }
+    }
+
+    void rows(const query &q, tableReader &table, const std::vector<rowFilter> &filters) {
+        std::vector<size_t> selected;
+        if (q.columns.empty())
+            for (size_t c = 0; c < table.getColumns().size(); ++c)
+                selected.push_back(c);
+        else
+            for (size_t start = 0; start <= q.columns.size(); ) {
+                size_t comma = std::min(q.columns.find(',', start), q.columns.size());
+                selected.push_back(table.columnIndex(q.columns.substr(start, comma - start)));
+                start = comma + 1;
+            }
+
+        for (size_t c = 0; c < selected.size(); ++c)
+            std::cout << (c ? "," : "") << table.getColumns()[selected[c]].name;
+        std::cout << '\n';
+        char field[32];
+        while (table.nextBlock())
+            for (size_t i = 0; i < table.rows(); ++i) {
+                if (!passes(filters, i))
+                    continue;
+                for (size_t c = 0; c < selected.size(); ++c) {
+                    std::snprintf(field, sizeof(field), "%.17g", table.values(selected[c])[i]);
+                    std::cout << (c ? "," : "") << field;
+                }
+                std::cout << '\n';
+            }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        const query q = parseArguments(argc, argv);
+        std::unique_ptr<tableReader> table = openTableReader(q.fileName);
+        std::vector<rowFilter> filters;
+        for (const std::string &f : q.filters)
+            filters.emplace_back(*table, f);
+
+        if (q.command == "columns") {
+            for (const column &c : table->getColumns())
+                std::cout << c.name << (c.type == columnType::int32 ? " (int32)" : " (float64)") << '\n';
+            return 0;
+        }
+        else if (q.command == "stats" || q.command == "histogram")
+            aggregate(q, *table, filters);
+        else if (q.command == "rows")
+            rows(q, *table, filters);
+        else
+            throw std::invalid_argument("Unknown command " + q.command);
+        std::cout.flush();
+
+        if (!table->complete())
+            std::cerr << "Warning: " << q.fileName << " ends in an unfinished row or chunk; the run may still be writing it" << std::endl;
+        return 0;
+    }
+    catch (const std::invalid_argument &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        usage(argv[0]);
+        return 1;
+    }
+    catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
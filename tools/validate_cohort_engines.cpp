@@ -0,0 +1,148 @@
+// Validation: checks that the time-to-death cohort engine (cohortEngine = events) gives the same output distribution as
+// the stepwise engine. For a few parameter sets, both engines run the same starting cohorts, each with its own random
+// numbers. Then they are compared on:
+// - the distribution of death times (two-sample Kolmogorov-Smirnov test);
+// - the mean damage of both traits at death and the mean gene 1 value over all sheep-timesteps alive (Welch t-test
+//   over the replicates).
+// Prints one line per check and the speed-up of the event engine. Exits with 1 if any check fails.
+//
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -pthread -I. tools/validate_cohort_engines.cpp allocations.cpp asyncsink.cpp checkpoint.cpp cohortevents.cpp
+//         herd.cpp herdchunks.cpp herddemes.cpp herdstats.cpp instrumentation.cpp output.cpp parameters.cpp randomnumbers.cpp sheep.cpp simulation.cpp threadpool.cpp
+//         -o validate_cohort_engines
+// Usage:
+//     ./validate_cohort_engines [replicates=N] [key=value ...]		(key=value sets model parameters for every parameter set)
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#include "parameters.h"
+#include "randomnumbers.h"
+#include "herd.h"
+#include "simulation.h"
+
+const double ksCritical = 1.95;				// Kolmogorov-Smirnov c(alpha) for alpha = 0.001
+const double tCritical = 3.5;				// |t| above this fails; about alpha = 0.001 for the replicate counts used here
+
+struct engineResult {
+    std::vector<long> deathsAt;				// Deaths per timestep, summed over replicates
+    long censored = 0;						// Still alive when the run stopped at maxGens
+    std::vector<double> damage1AtDeath;		// Per replicate
+    std::vector<double> damage2AtDeath;
+    std::vector<double> gen1Alive;
+    double seconds = 0;
+};
+
+engineResult runEngine(parameters p, const std::string &engine, const int &replicates, const unsigned int &seed) {
+    p.cohortEngine = engine;
+    engineResult r;
+    for (int rep = 0; rep < replicates; ++rep) {
+        seedRng(replicateSeed(seed, rep));					// Same starting cohort for both engines ..
+        herd cohort = initiatePopulation(p);
+        seedRng(replicateSeed(seed + (engine == "events"), rep + replicates));	// .. but different random numbers afterwards
+
+        double d1 = 0, d2 = 0, g1 = 0;
+        long deaths = 0, aliveSteps = 0, lastAlive = 0;
+        auto start = std::chrono::steady_clock::now();
+        runCohort(p, std::move(cohort), [&](const cohortStats &s) {
+            if (s.time >= long(r.deathsAt.size()))
+                r.deathsAt.resize(s.time + 1, 0);
+            r.deathsAt[s.time] += s.iDead;
+            deaths += s.iDead;
+            d1 += s.damage1Dead;
+            d2 += s.damage2Dead;
+            g1 += s.gen1Total;
+            aliveSteps += s.iAlive;
+            lastAlive = s.iAlive;
+        });
+        r.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        r.censored += lastAlive;
+        r.damage1AtDeath.push_back(deaths ? d1 / deaths : 0);
+        r.damage2AtDeath.push_back(deaths ? d2 / deaths : 0);
+        r.gen1Alive.push_back(aliveSteps ? g1 / aliveSteps : 0);
+    }
+    return r;
+}
+
+double ksStatistic(const engineResult &a, const engineResult &b) {
+    // Largest distance between the two death-time distributions; censored sheep count as dying after the last timestep
+    long nA = a.censored, nB = b.censored;
+    for (long d : a.deathsAt) nA += d;
+    for (long d : b.deathsAt) nB += d;
+    double cdfA = 0, cdfB = 0, dMax = 0;
+    for (size_t t = 0; t < std::max(a.deathsAt.size(), b.deathsAt.size()); ++t) {
+        cdfA += t < a.deathsAt.size() ? double(a.deathsAt[t]) / nA : 0;
+        cdfB += t < b.deathsAt.size() ? double(b.deathsAt[t]) / nB : 0;
+        dMax = std::max(dMax, std::fabs(cdfA - cdfB));
+    }
+    return dMax / (ksCritical * std::sqrt(double(nA + nB) / (double(nA) * nB)));	// In units of the critical value
+}
+
+double welchT(const std::vector<double> &a, const std::vector<double> &b) {
+    auto moments = [](const std::vector<double> &x, double &mean, double &var) {
+        mean = var = 0;
+        for (double v : x) mean += v;
+        mean /= x.size();
+        for (double v : x) var += (v - mean) * (v - mean);
+        var /= x.size() - 1;
+    };
+    double mA, vA, mB, vB;
+    moments(a, mA, vA);
+    moments(b, mB, vB);
+    double se = std::sqrt(vA / a.size() + vB / b.size());
+    return se > 0 ? (mA - mB) / se : (mA == mB ? 0.0 : INFINITY);
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        parameters base;
+        base.popSize = 2000;
+        int replicates = 30;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            size_t eq = arg.find('=');
+            if (eq == std::string::npos)
+                throw std::invalid_argument("Expected key=value, got: " + arg);
+            if (arg.substr(0, eq) == "replicates")
+                replicates = std::stoi(arg.substr(eq + 1));
+            else
+                setParameter(base, arg.substr(0, eq), arg.substr(eq + 1));
+        }
+
+        struct variant { std::string name; std::vector<std::pair<std::string, std::string>> settings; };
+        const std::vector<variant> variants = {
+            { "defaults", {} },
+            { "no extrinsic deaths", { { "extDeathRate", "0" } } },
+            { "high extrinsic deaths", { { "extDeathRate", "0.2" } } },
+            { "slow damage, long lives", { { "baseDamage", "0.02" } } },
+            { "truncated at maxGens", { { "baseDamage", "0.02" }, { "maxGens", "60" } } },
+        };
+
+        bool allPassed = true;
+        for (const variant &v : variants) {
+            parameters p = base;
+            for (const auto &kv : v.settings)
+                setParameter(p, kv.first, kv.second);
+            engineResult stepwise = runEngine(p, "stepwise", replicates, 12345);
+            engineResult events = runEngine(p, "events", replicates, 12345);
+
+            double ks = ksStatistic(stepwise, events);
+            double t[3] = { welchT(stepwise.damage1AtDeath, events.damage1AtDeath), welchT(stepwise.damage2AtDeath, events.damage2AtDeath),
+                            welchT(stepwise.gen1Alive, events.gen1Alive) };
+            bool passed = ks < 1 && std::fabs(t[0]) < tCritical && std::fabs(t[1]) < tCritical && std::fabs(t[2]) < tCritical;
+            allPassed = allPassed && passed;
+
+            std::cout << (passed ? "PASS " : "FAIL ") << v.name << ": KS " << ks << " of critical, t damage1 " << t[0] << ", t damage2 " << t[1]
+                      << ", t gen1 " << t[2] << "; stepwise " << stepwise.seconds << " s, events " << events.seconds << " s ("
+                      << stepwise.seconds / events.seconds << "x)" << std::endl;
+        }
+        return allPassed ? 0 : 1;
+    }
+    catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}